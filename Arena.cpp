@@ -0,0 +1,121 @@
+#include "Arena.hpp"
+
+#include <vector>
+
+//---------------------------------------------------------------------------
+static Ogre::Vector3 toOgre(const float* v)
+{
+    return Ogre::Vector3(v[0], v[1], v[2]);
+}
+
+//---------------------------------------------------------------------------
+Arena::Arena(BulletPhysics* physics, Ogre::SceneManager* sceneMgr, const Level& level,
+    bool batched)
+    : mPhysicsEngine(physics),
+    mSceneMgr(sceneMgr),
+    mLevel(level),
+    mBatched(batched),
+    mWall(physics, sceneMgr)
+{
+}
+
+//---------------------------------------------------------------------------
+void Arena::build()
+{
+    if (mSceneMgr)
+    {
+        buildMeshes();
+        buildLights();
+    }
+
+    const LevelHeader& header = mLevel.getHeader();
+    const LevelCollider* colliders = mLevel.getColliders();
+
+    for (uint32_t i = 0; i < header.colliderCount; ++i)
+    {
+        const LevelCollider& collider = colliders[i];
+        const float* p = collider.position;
+
+        if (collider.type == LEVEL_PLANE)
+        {
+            mWall.createGroundPhysics(p[0], p[1], p[2],
+                btVector3(collider.normal[0], collider.normal[1], collider.normal[2]));
+        }
+        else
+        {
+            mWall.createWallPhysics(p[0], p[1], p[2],
+                collider.halfExtents[0], collider.halfExtents[1], collider.halfExtents[2]);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+void Arena::buildMeshes()
+{
+    const LevelHeader& header = mLevel.getHeader();
+    const LevelSurface* surfaces = mLevel.getSurfaces();
+
+    mWall.setMaterialName(header.material);
+
+    Ogre::StaticGeometry* batch = 0;
+    if (mBatched)
+    {
+        // One region big enough for the whole arena
+        Ogre::Vector3 size = toOgre(header.boundsMax) - toOgre(header.boundsMin);
+        batch = mSceneMgr->createStaticGeometry(ARENA_STATIC_GEOMETRY);
+        batch->setRegionDimensions(2 * size);
+        batch->setOrigin(toOgre(header.boundsMin) - size / 2);
+        batch->setCastShadows(false);
+    }
+
+    std::vector<Ogre::Entity*> walls;
+    for (uint32_t i = 0; i < header.surfaceCount; ++i)
+    {
+        const LevelSurface& surface = surfaces[i];
+        walls.push_back(mWall.createWall(surface.name,
+            surface.position[0], surface.position[1], surface.position[2],
+            surface.height, surface.width, toOgre(surface.facing), toOgre(surface.up), batch));
+    }
+
+    if (batch)
+    {
+        batch->build();
+
+        // The batch holds its own copy of the geometry
+        for (size_t i = 0; i < walls.size(); ++i)
+        {
+            mSceneMgr->destroyEntity(walls[i]);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+void Arena::buildLights()
+{
+    const LevelHeader& header = mLevel.getHeader();
+    const LevelLight* lights = mLevel.getLights();
+
+    mSceneMgr->setAmbientLight(Ogre::ColourValue(header.ambient[0], header.ambient[1],
+        header.ambient[2]));
+
+    for (size_t i = 0; i < header.lightCount; ++i)
+    {
+        const LevelLight& level = lights[i];
+        Ogre::ColourValue colour(level.colour[0], level.colour[1], level.colour[2]);
+
+        Ogre::Light* light = mSceneMgr->createLight("ArenaLight" + Ogre::StringConverter::toString(i));
+        light->setDiffuseColour(colour);
+        light->setSpecularColour(colour);
+
+        if (level.type == LEVEL_POINT)
+        {
+            light->setType(Ogre::Light::LT_POINT);
+            light->setPosition(toOgre(level.vector));
+        }
+        else
+        {
+            light->setType(Ogre::Light::LT_DIRECTIONAL);
+            light->setDirection(toOgre(level.vector));
+        }
+    }
+}
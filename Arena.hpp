@@ -0,0 +1,36 @@
+#ifndef Arena_hpp
+#define Arena_hpp
+
+#include "BulletPhysics.hpp"
+#include "Level.hpp"
+#include "Wall.hpp"
+
+#include <OgreSceneManager.h>
+
+#define ARENA_STATIC_GEOMETRY "arena"
+
+// The static colliders, render surfaces and lights of a level. Without a
+// scene manager only the physics bodies are built, for headless runs and
+// benches. Batched, the surfaces are baked into one StaticGeometry region;
+// they share a material, so the whole arena is a single draw call and
+// never walks the scene graph.
+class Arena
+{
+public:
+    Arena(BulletPhysics* physics, Ogre::SceneManager* sceneMgr, const Level& level,
+        bool batched = true);
+
+    void build();
+
+private:
+    void buildMeshes();
+    void buildLights();
+
+    BulletPhysics* mPhysicsEngine;
+    Ogre::SceneManager* mSceneMgr;
+    const Level& mLevel;
+    bool mBatched;
+    Wall mWall;
+};
+
+#endif
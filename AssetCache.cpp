@@ -0,0 +1,144 @@
+#include "AssetCache.hpp"
+
+#include <OgreException.h>
+#include <OgreLogManager.h>
+#include <OgreSubMesh.h>
+
+//---------------------------------------------------------------------------
+AssetCache::AssetCache()
+    : mFailures(0)
+{
+}
+
+//---------------------------------------------------------------------------
+void AssetCache::addMesh(const std::string& name)
+{
+    mMeshNames.push_back(name);
+}
+
+//---------------------------------------------------------------------------
+void AssetCache::addMaterial(const std::string& name)
+{
+    mMaterialNames.push_back(name);
+}
+
+//---------------------------------------------------------------------------
+bool AssetCache::preload()
+{
+    size_t failures = mFailures;
+
+    for (size_t i = 0; i < mMeshNames.size(); ++i)
+    {
+        loadMesh(mMeshNames[i]);
+    }
+
+    for (size_t i = 0; i < mMaterialNames.size(); ++i)
+    {
+        loadMaterial(mMaterialNames[i]);
+    }
+
+    mMeshNames.clear();
+    mMaterialNames.clear();
+
+    return mFailures == failures;
+}
+
+//---------------------------------------------------------------------------
+bool AssetCache::loadMesh(const std::string& name)
+{
+    if (mMeshes.count(name))
+    {
+        return true;
+    }
+
+    Ogre::MeshPtr mesh;
+    try
+    {
+        mesh = Ogre::MeshManager::getSingleton().load(name,
+            Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+    }
+    catch (Ogre::Exception& e)
+    {
+        Ogre::LogManager::getSingletonPtr()->logMessage("*** Asset cache: mesh " + name
+            + " failed to load: " + e.getFullDescription() + " ***");
+        ++mFailures;
+        return false;
+    }
+
+    mMeshes[name] = mesh;
+
+    bool ok = true;
+    for (unsigned short i = 0; i < mesh->getNumSubMeshes(); ++i)
+    {
+        ok = loadMaterial(mesh->getSubMesh(i)->getMaterialName()) && ok;
+    }
+
+    return ok;
+}
+
+//---------------------------------------------------------------------------
+bool AssetCache::loadMaterial(const std::string& name)
+{
+    if (mMaterials.count(name))
+    {
+        return true;
+    }
+
+    Ogre::MaterialPtr material = Ogre::MaterialManager::getSingleton().getByName(name);
+    if (material.isNull())
+    {
+        Ogre::LogManager::getSingletonPtr()->logMessage("*** Asset cache: material "
+            + name + " is not defined ***");
+        ++mFailures;
+        return false;
+    }
+
+    try
+    {
+        // Compiles the techniques, loads the textures and the GPU programs
+        material->load();
+    }
+    catch (Ogre::Exception& e)
+    {
+        Ogre::LogManager::getSingletonPtr()->logMessage("*** Asset cache: material " + name
+            + " failed to load: " + e.getFullDescription() + " ***");
+        ++mFailures;
+        return false;
+    }
+
+    if (material->getNumSupportedTechniques() == 0)
+    {
+        Ogre::LogManager::getSingletonPtr()->logMessage("*** Asset cache: material "
+            + name + " has no technique this card supports ***");
+        ++mFailures;
+        return false;
+    }
+
+    mMaterials[name] = material;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+Ogre::MeshPtr AssetCache::getMesh(const std::string& name) const
+{
+    std::map<std::string, Ogre::MeshPtr>::const_iterator it = mMeshes.find(name);
+    return it == mMeshes.end() ? Ogre::MeshPtr() : it->second;
+}
+
+//---------------------------------------------------------------------------
+size_t AssetCache::getMeshCount() const
+{
+    return mMeshes.size();
+}
+
+//---------------------------------------------------------------------------
+size_t AssetCache::getMaterialCount() const
+{
+    return mMaterials.size();
+}
+
+//---------------------------------------------------------------------------
+size_t AssetCache::getFailures() const
+{
+    return mFailures;
+}
@@ -0,0 +1,47 @@
+#ifndef AssetCache_hpp
+#define AssetCache_hpp
+
+#include <OgreMaterialManager.h>
+#include <OgreMeshManager.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Everything the game draws, loaded in one go before play starts so that a
+// spawn never reads a file or compiles a shader mid-frame. Loading a mesh
+// also loads the materials its submeshes use, and loading a material loads
+// its textures and GPU programs. The cache keeps a handle to each, so Ogre
+// never unloads them, and later loads by name get the same shared resource.
+class AssetCache
+{
+public:
+    AssetCache();
+
+    void addMesh(const std::string& name);
+    void addMaterial(const std::string& name);
+
+    // Loads everything added so far. False if anything is missing or broken;
+    // each failure is logged.
+    bool preload();
+
+    Ogre::MeshPtr getMesh(const std::string& name) const;
+
+    size_t getMeshCount() const;
+    size_t getMaterialCount() const;
+    size_t getFailures() const;
+
+private:
+    bool loadMesh(const std::string& name);
+    bool loadMaterial(const std::string& name);
+
+    std::vector<std::string> mMeshNames;
+    std::vector<std::string> mMaterialNames;
+
+    std::map<std::string, Ogre::MeshPtr> mMeshes;
+    std::map<std::string, Ogre::MaterialPtr> mMaterials;
+
+    size_t mFailures;
+};
+
+#endif
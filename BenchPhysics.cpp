@@ -0,0 +1,380 @@
+#include "Arena.hpp"
+#include "BulletPhysics.hpp"
+#include "Cat.hpp"
+#include "CatPool.hpp"
+#include "FixedTimestep.hpp"
+#include "OgreMotionState.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define BENCH_CAT_COUNTS "100,500,1000,2500,5000,10000"
+#define BENCH_STEPS 600
+#define BENCH_WARMUP_STEPS 60
+#define BENCH_SPAWN_HEIGHT 100.0f
+#define BENCH_SEED 354
+
+struct BenchOptions
+{
+    std::vector<int> cats;
+    int steps;
+    int warmup;
+    bool serial;
+    bool multithreaded;
+    int threads;
+};
+
+// One row of output
+struct BenchResult
+{
+    int cats;
+    bool multithreaded;
+    int threads;
+
+    // Milliseconds per stepSimulation
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+
+    double pairsAverage; // Broadphase overlapping pairs
+    int pairsMax;
+    double manifoldsAverage; // Narrowphase contact manifolds
+
+    size_t bytesPerCat; // Bullet heap plus the Cat and its motion state
+};
+
+//---------------------------------------------------------------------------
+// Bullet allocates through these once installed, so the heap it owns can be
+// measured. Each block carries its size in front of it.
+static std::atomic<size_t> sBulletBytes(0);
+
+static void* countingAlloc(size_t size)
+{
+    char* block = static_cast<char*>(std::malloc(size + sizeof(std::max_align_t)));
+    *reinterpret_cast<size_t*>(block) = size;
+    sBulletBytes += size;
+    return block + sizeof(std::max_align_t);
+}
+
+static void countingFree(void* memblock)
+{
+    if (!memblock)
+    {
+        return;
+    }
+
+    char* block = static_cast<char*>(memblock) - sizeof(std::max_align_t);
+    sBulletBytes -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+}
+
+//---------------------------------------------------------------------------
+static double percentile(const std::vector<double>& sorted, const double q)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    size_t index = size_t(q * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+//---------------------------------------------------------------------------
+// Launches the cats from a grid of spawn points above the ground, in a spread
+// of directions that is the same for every world
+static void spawnCats(BulletPhysics* physics, const Level& level, btCollisionShape* shape,
+    const int count, std::vector<Cat*>& cats)
+{
+    std::srand(BENCH_SEED);
+
+    const float spacing = 3 * CAT_RADIUS;
+    const btVector3 boundsMin = level.getBoundsMin();
+    const btVector3 boundsMax = level.getBoundsMax();
+    const float startX = boundsMin.x() + 2 * CAT_RADIUS;
+    const float startZ = boundsMin.z() + 2 * CAT_RADIUS;
+    const int perRow = std::max(1, int((std::min(boundsMax.x() - boundsMin.x(),
+        boundsMax.z() - boundsMin.z()) - 4 * CAT_RADIUS) / spacing));
+
+    for (int i = 0; i < count; ++i)
+    {
+        Cat* cat = new Cat(physics, 0, 0);
+        cat->initCatPhysics(CAT_MASS, shape);
+
+        btTransform transform;
+        transform.setIdentity();
+        transform.setOrigin(btVector3(
+            startX + (i % perRow) * spacing,
+            BENCH_SPAWN_HEIGHT + (i / (perRow * perRow)) * spacing,
+            startZ + ((i / perRow) % perRow) * spacing));
+
+        btVector3 direction(std::rand() % 201 - 100, std::rand() % 101, std::rand() % 201 - 100);
+        if (direction.length2() < 1)
+        {
+            direction = btVector3(0, 1, 0);
+        }
+
+        cat->launchFrom(transform, direction);
+        cats.push_back(cat);
+    }
+}
+
+//---------------------------------------------------------------------------
+// Deletes whatever the arena left in the world
+static void clearWorld(BulletPhysics* physics)
+{
+    btDiscreteDynamicsWorld* world = physics->getDynamicsWorld();
+
+    while (world->getNumCollisionObjects() > 0)
+    {
+        btCollisionObject* object = world->getCollisionObjectArray()[0];
+        btRigidBody* body = btRigidBody::upcast(object);
+
+        if (body)
+        {
+            delete body->getMotionState();
+        }
+
+        world->removeCollisionObject(object);
+        delete object->getCollisionShape();
+        delete object;
+    }
+}
+
+//---------------------------------------------------------------------------
+// False when the multithreaded world was asked for but Bullet cannot build it
+static bool runScenario(const PhysicsConfig& config, const Level& level, const int count,
+    const BenchOptions& options, BenchResult& result)
+{
+    BulletPhysics physics;
+    physics.initObjects(config);
+
+    if (config.multithreaded && !physics.isMultithreaded())
+    {
+        return false;
+    }
+
+    physics.getDynamicsWorld()->setGravity(PHYSICS_GRAVITY);
+
+    Arena arena(&physics, 0, level);
+    arena.build();
+
+    btCollisionShape* shape = new btSphereShape(CAT_RADIUS);
+    std::vector<Cat*> cats;
+    cats.reserve(count);
+
+    size_t bytesBefore = sBulletBytes;
+    spawnCats(&physics, level, shape, count, cats);
+    size_t bytesAfter = sBulletBytes;
+
+    btDiscreteDynamicsWorld* world = physics.getDynamicsWorld();
+    const btScalar dt = btScalar(PHYSICS_STEP);
+
+    for (int i = 0; i < options.warmup; ++i)
+    {
+        world->stepSimulation(dt, 0);
+    }
+
+    std::vector<double> times;
+    times.reserve(options.steps);
+    double pairsTotal = 0.0;
+    double manifoldsTotal = 0.0;
+    int pairsMax = 0;
+
+    for (int i = 0; i < options.steps; ++i)
+    {
+        std::chrono::steady_clock::time_point stepStart = std::chrono::steady_clock::now();
+        world->stepSimulation(dt, 0);
+        times.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - stepStart).count());
+
+        int pairs = world->getBroadphase()->getOverlappingPairCache()->getNumOverlappingPairs();
+        pairsTotal += pairs;
+        pairsMax = std::max(pairsMax, pairs);
+        manifoldsTotal += world->getDispatcher()->getNumManifolds();
+    }
+
+    std::sort(times.begin(), times.end());
+
+    double total = 0.0;
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        total += times[i];
+    }
+
+    int steps = std::max(options.steps, 1);
+    result.cats = count;
+    result.multithreaded = physics.isMultithreaded();
+    result.threads = physics.getThreadCount();
+    result.mean = total / steps;
+    result.p50 = percentile(times, 0.50);
+    result.p90 = percentile(times, 0.90);
+    result.p99 = percentile(times, 0.99);
+    result.max = times.empty() ? 0.0 : times.back();
+    result.pairsAverage = pairsTotal / steps;
+    result.pairsMax = pairsMax;
+    result.manifoldsAverage = manifoldsTotal / steps;
+    result.bytesPerCat = (count > 0 ? (bytesAfter - bytesBefore) / count : 0)
+        + sizeof(Cat) + sizeof(OgreMotionState);
+
+    for (size_t i = 0; i < cats.size(); ++i)
+    {
+        delete cats[i];
+    }
+    delete shape;
+    clearWorld(&physics);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+static void printResult(const BenchResult& result)
+{
+    std::cout << result.cats << ","
+              << (result.multithreaded ? "mt" : "serial") << ","
+              << result.threads << ","
+              << result.mean << ","
+              << result.p50 << ","
+              << result.p90 << ","
+              << result.p99 << ","
+              << result.max << ","
+              << result.pairsAverage << ","
+              << result.pairsMax << ","
+              << result.manifoldsAverage << ","
+              << result.bytesPerCat << std::endl;
+}
+
+//---------------------------------------------------------------------------
+static std::vector<int> parseCounts(const std::string& list)
+{
+    std::vector<int> counts;
+    std::istringstream in(list);
+    std::string item;
+
+    while (std::getline(in, item, ','))
+    {
+        int count = std::atoi(item.c_str());
+        if (count > 0)
+        {
+            counts.push_back(count);
+        }
+    }
+
+    return counts;
+}
+
+//---------------------------------------------------------------------------
+// Steps the game arena full of cats and prints one CSV row per scenario on
+// stdout, so runs can be diffed between builds. Progress goes to stderr.
+// Usage: bench_physics [--cats 100,1000] [--steps N] [--warmup N]
+//                      [--serial | --mt] [--threads N]
+int main(int argc, char *argv[])
+{
+    // Before anything allocates through Bullet
+    btAlignedAllocSetCustom(countingAlloc, countingFree);
+
+    BenchOptions options;
+    options.cats = parseCounts(BENCH_CAT_COUNTS);
+    options.steps = BENCH_STEPS;
+    options.warmup = BENCH_WARMUP_STEPS;
+    options.serial = true;
+    options.multithreaded = true;
+    options.threads = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--cats" && hasValue)
+        {
+            options.cats = parseCounts(argv[++i]);
+        }
+        else if (arg == "--steps" && hasValue)
+        {
+            options.steps = std::atoi(argv[++i]);
+        }
+        else if (arg == "--warmup" && hasValue)
+        {
+            options.warmup = std::atoi(argv[++i]);
+        }
+        else if (arg == "--threads" && hasValue)
+        {
+            options.threads = std::atoi(argv[++i]);
+        }
+        else if (arg == "--serial")
+        {
+            options.multithreaded = false;
+        }
+        else if (arg == "--mt")
+        {
+            options.serial = false;
+        }
+        else
+        {
+            std::cerr << "bench_physics: unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    Level level;
+    if (!level.load())
+    {
+        std::cerr << "bench_physics: could not load level " << LEVEL_FILE << std::endl;
+        return 1;
+    }
+
+    PhysicsConfig serial;
+    serial.load(PHYSICS_CONFIG_FILE);
+    serial.multithreaded = false;
+
+    PhysicsConfig parallel = serial;
+    parallel.multithreaded = true;
+    if (options.threads > 0)
+    {
+        parallel.threads = options.threads;
+    }
+
+    std::cout << "cats,world,threads,mean_ms,p50_ms,p90_ms,p99_ms,max_ms,"
+              << "pairs_avg,pairs_max,manifolds_avg,bytes_per_cat" << std::endl;
+
+    bool multithreaded = options.multithreaded;
+
+    for (size_t i = 0; i < options.cats.size(); ++i)
+    {
+        BenchResult result;
+
+        if (options.serial)
+        {
+            std::cerr << options.cats[i] << " cats, serial world..." << std::endl;
+            runScenario(serial, level, options.cats[i], options, result);
+            printResult(result);
+        }
+
+        if (multithreaded)
+        {
+            std::cerr << options.cats[i] << " cats, multithreaded world..." << std::endl;
+            if (runScenario(parallel, level, options.cats[i], options, result))
+            {
+                printResult(result);
+            }
+            else
+            {
+                std::cerr << "bench_physics: Bullet was built without BT_THREADSAFE, "
+                          << "skipping the multithreaded world" << std::endl;
+                multithreaded = false;
+            }
+        }
+    }
+
+    return 0;
+}
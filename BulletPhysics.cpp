@@ -1,19 +1,243 @@
 #include "BulletPhysics.hpp"
+#include "FixedTimestep.hpp"
+#include "OgreMotionState.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
 
+#if BT_THREADSAFE
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <LinearMath/btThreads.h>
+#endif
+
+#define STATE_IN_WORLD 0x01
+
+struct StateHeader
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved;
+  uint32_t count;
+};
+
+// One tracked object
+struct StateRecord
+{
+  uint32_t flags;
+  int32_t group;
+  int32_t mask;
+  int32_t activation;
+  float deactivationTime;
+  float origin[3];
+  float rotation[4]; // x, y, z, w
+  float linear[3];
+  float angular[3];
+};
+
 std::ostream& operator << (std::ostream& out, const btVector3& vec)
 {
   out << "(" << vec.x() << ", " << vec.y() << ", " << vec.z() << ")";
 }
 
-BulletPhysics::BulletPhysics() {}
+PhysicsConfig::PhysicsConfig()
+  : multithreaded(false),
+    threads(0),
+    solvers(0),
+    dispatcherGrain(40),
+    manifoldPoolSize(4096),
+    maxSubSteps(PHYSICS_MAX_SUBSTEPS)
+{
+}
 
-void BulletPhysics::initObjects()
+bool PhysicsConfig::load(const std::string& fileName)
 {
-    collisionConfiguration = new btDefaultCollisionConfiguration();
-    dispatcher = new btCollisionDispatcher(collisionConfiguration);
+    std::ifstream file(fileName.c_str());
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string line;
+    int number = 0;
+    while (std::getline(file, line))
+    {
+        ++number;
+        line = line.substr(0, line.find('#'));
+
+        size_t split = line.find('=');
+        if (split == std::string::npos)
+        {
+            continue;
+        }
+
+        std::string key, value;
+        std::istringstream(line.substr(0, split)) >> key;
+        std::istringstream(line.substr(split + 1)) >> value;
+
+        // Every key but Multithreaded is a whole number with a lower bound
+        int* setting = 0;
+        int minimum = 0;
+
+        if (key == "Multithreaded")
+        {
+            if (value == "true" || value == "yes" || value == "1")
+            {
+                this->multithreaded = true;
+            }
+            else if (value == "false" || value == "no" || value == "0")
+            {
+                this->multithreaded = false;
+            }
+            else
+            {
+                std::cerr << fileName << ":" << number << ": bad value '" << value
+                          << "' for " << key << ", keeping the default" << std::endl;
+            }
+            continue;
+        }
+        else if (key == "Threads")
+        {
+            setting = &this->threads;
+        }
+        else if (key == "Solvers")
+        {
+            setting = &this->solvers;
+        }
+        else if (key == "DispatcherGrain")
+        {
+            setting = &this->dispatcherGrain;
+            minimum = 1;
+        }
+        else if (key == "ManifoldPoolSize")
+        {
+            setting = &this->manifoldPoolSize;
+            minimum = 1;
+        }
+        else if (key == "MaxSubSteps")
+        {
+            setting = &this->maxSubSteps;
+            minimum = 1;
+        }
+        else
+        {
+            std::cerr << fileName << ":" << number << ": unknown key " << key << std::endl;
+            continue;
+        }
+
+        // Anything unparseable keeps its default
+        char* end = 0;
+        long parsed = std::strtol(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0' || parsed < INT_MIN || parsed > INT_MAX)
+        {
+            std::cerr << fileName << ":" << number << ": bad value '" << value
+                      << "' for " << key << ", keeping the default" << std::endl;
+            continue;
+        }
+
+        if (parsed < minimum)
+        {
+            std::cerr << fileName << ":" << number << ": " << key << " raised from "
+                      << parsed << " to " << minimum << std::endl;
+            parsed = minimum;
+        }
+        *setting = int(parsed);
+    }
+
+    return true;
+}
+
+BulletPhysics::BulletPhysics()
+  : collisionConfiguration(0),
+    dispatcher(0),
+    overlappingPairCache(0),
+    solver(0),
+    solverMt(0),
+    dynamicsWorld(0),
+    taskScheduler(0),
+    multithreaded(false),
+    threadCount(1)
+{
+}
+
+BulletPhysics::~BulletPhysics()
+{
+    // Contacts cleaned up with the world have nobody to go to
+    contactDispatcher.uninstall();
+
+    // Bodies and shapes belong to whoever created them
+    delete dynamicsWorld;
+    delete solverMt;
+    delete solver;
+    delete overlappingPairCache;
+    delete dispatcher;
+    delete collisionConfiguration;
+
+#if BT_THREADSAFE
+    // The worker pool goes with the world that used it
+    if (taskScheduler)
+    {
+        if (btGetTaskScheduler() == taskScheduler)
+        {
+            btSetTaskScheduler(0);
+        }
+        delete taskScheduler;
+    }
+#endif
+}
+
+void BulletPhysics::initObjects(const PhysicsConfig& config)
+{
+    btDefaultCollisionConstructionInfo constructionInfo;
+    constructionInfo.m_defaultMaxPersistentManifoldPoolSize = config.manifoldPoolSize;
+    constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = config.manifoldPoolSize;
+
+    collisionConfiguration = new btDefaultCollisionConfiguration(constructionInfo);
     overlappingPairCache = new btDbvtBroadphase();
     overlappingPairCache->getOverlappingPairCache()->setInternalGhostPairCallback(new btGhostPairCallback());
+    contactDispatcher.install();
+
+#if BT_THREADSAFE
+    taskScheduler = config.multithreaded ? btCreateDefaultTaskScheduler() : 0;
+    if (taskScheduler)
+    {
+        int threads = config.threads > 0 ? config.threads : taskScheduler->getMaxNumThreads();
+        taskScheduler->setNumThreads(std::min(threads, taskScheduler->getMaxNumThreads()));
+        btSetTaskScheduler(taskScheduler);
+
+        multithreaded = true;
+        threadCount = taskScheduler->getNumThreads();
+
+        // Each island gets a solver from the pool; the Mt solver takes islands
+        // too large to split, like a pile of cats on the ground
+        int solvers = config.solvers > 0 ? config.solvers : threadCount;
+        btConstraintSolverPoolMt* solverPool = new btConstraintSolverPoolMt(solvers);
+        solver = solverPool;
+        solverMt = new btSequentialImpulseConstraintSolverMt();
+
+        dispatcher = new btCollisionDispatcherMt(collisionConfiguration, config.dispatcherGrain);
+        dynamicsWorld = new btDiscreteDynamicsWorldMt(dispatcher,
+                                                      overlappingPairCache,
+                                                      solverPool,
+                                                      solverMt,
+                                                      collisionConfiguration);
+        return;
+    }
+#endif
+
+    if (config.multithreaded)
+    {
+        std::cerr << "BulletPhysics::initObjects() : Bullet was built without BT_THREADSAFE, "
+                  << "using the serial world." << std::endl;
+    }
+
+    dispatcher = new btCollisionDispatcher(collisionConfiguration);
     solver = new btSequentialImpulseConstraintSolver();
     dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher,
                                                 overlappingPairCache,
@@ -55,3 +279,216 @@ size_t BulletPhysics::getCollisionObjectCount()
 {
     return this->dynamicsWorld->getNumCollisionObjects();
 }
+
+void BulletPhysics::queueMotionStateSync(OgreMotionState* state)
+{
+    this->pendingSyncs.push_back(state);
+}
+
+std::vector<OgreMotionState *>& BulletPhysics::getPendingSyncs()
+{
+    return this->pendingSyncs;
+}
+
+ContactDispatcher& BulletPhysics::getContactDispatcher()
+{
+    return this->contactDispatcher;
+}
+
+bool BulletPhysics::isMultithreaded()
+{
+    return this->multithreaded;
+}
+
+int BulletPhysics::getThreadCount()
+{
+    return this->threadCount;
+}
+
+void BulletPhysics::trackStateObject(btCollisionObject* object, OgreMotionState* state)
+{
+    this->stateObjects.push_back(object);
+    this->stateMotionStates.push_back(state);
+}
+
+size_t BulletPhysics::getStateObjectCount()
+{
+    return this->stateObjects.size();
+}
+
+btCollisionObject* BulletPhysics::getStateObject(const size_t index)
+{
+    return this->stateObjects.at(index);
+}
+
+void BulletPhysics::writeState(std::vector<char>& buffer)
+{
+    StateHeader header = { PHYSICS_STATE_MAGIC, PHYSICS_STATE_VERSION, 0,
+        uint32_t(this->stateObjects.size()) };
+
+    buffer.resize(sizeof(header) + this->stateObjects.size() * sizeof(StateRecord));
+    std::memcpy(&buffer[0], &header, sizeof(header));
+    StateRecord* records = reinterpret_cast<StateRecord*>(&buffer[sizeof(header)]);
+
+    for (size_t i = 0; i < this->stateObjects.size(); ++i)
+    {
+        btCollisionObject* object = this->stateObjects[i];
+        const btBroadphaseProxy* proxy = object->getBroadphaseHandle();
+        StateRecord& record = records[i];
+
+        record.flags = proxy ? STATE_IN_WORLD : 0;
+        record.group = proxy ? proxy->m_collisionFilterGroup : 0;
+        record.mask = proxy ? proxy->m_collisionFilterMask : 0;
+        record.activation = object->getActivationState();
+        record.deactivationTime = object->getDeactivationTime();
+
+        const btTransform& transform = object->getWorldTransform();
+        btQuaternion rotation = transform.getRotation();
+        btVector3 linear(0, 0, 0);
+        btVector3 angular(0, 0, 0);
+
+        btRigidBody* body = btRigidBody::upcast(object);
+        if (body)
+        {
+            linear = body->getLinearVelocity();
+            angular = body->getAngularVelocity();
+        }
+
+        for (int j = 0; j < 3; ++j)
+        {
+            record.origin[j] = transform.getOrigin()[j];
+            record.linear[j] = linear[j];
+            record.angular[j] = angular[j];
+        }
+        record.rotation[0] = rotation.x();
+        record.rotation[1] = rotation.y();
+        record.rotation[2] = rotation.z();
+        record.rotation[3] = rotation.w();
+    }
+}
+
+bool BulletPhysics::readState(const std::vector<char>& buffer)
+{
+    StateHeader header;
+    if (buffer.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, &buffer[0], sizeof(header));
+
+    if (header.magic != PHYSICS_STATE_MAGIC || header.version != PHYSICS_STATE_VERSION
+        || header.count != this->stateObjects.size()
+        || buffer.size() != sizeof(header) + header.count * sizeof(StateRecord))
+    {
+        return false;
+    }
+
+    const StateRecord* records = reinterpret_cast<const StateRecord*>(&buffer[sizeof(header)]);
+
+    for (size_t i = 0; i < this->stateObjects.size(); ++i)
+    {
+        btCollisionObject* object = this->stateObjects[i];
+        btRigidBody* body = btRigidBody::upcast(object);
+        const StateRecord& record = records[i];
+
+        bool inWorld = object->getBroadphaseHandle() != 0;
+        bool wanted = (record.flags & STATE_IN_WORLD) != 0;
+
+        if (inWorld && !wanted)
+        {
+            if (body)
+            {
+                this->dynamicsWorld->removeRigidBody(body);
+            }
+            else
+            {
+                this->dynamicsWorld->removeCollisionObject(object);
+            }
+        }
+
+        btTransform transform(
+            btQuaternion(record.rotation[0], record.rotation[1], record.rotation[2], record.rotation[3]),
+            btVector3(record.origin[0], record.origin[1], record.origin[2]));
+        btVector3 linear(record.linear[0], record.linear[1], record.linear[2]);
+        btVector3 angular(record.angular[0], record.angular[1], record.angular[2]);
+
+        object->setWorldTransform(transform);
+        object->setInterpolationWorldTransform(transform);
+
+        if (body)
+        {
+            body->setLinearVelocity(linear);
+            body->setAngularVelocity(angular);
+            body->setInterpolationLinearVelocity(linear);
+            body->setInterpolationAngularVelocity(angular);
+            body->clearForces();
+
+            // Kinematic bodies read their pose back from the motion state
+            if (this->stateMotionStates[i])
+            {
+                this->stateMotionStates[i]->reset(transform);
+            }
+            else if (body->getMotionState())
+            {
+                body->getMotionState()->setWorldTransform(transform);
+            }
+        }
+
+        if (wanted && !inWorld)
+        {
+            if (body)
+            {
+                this->dynamicsWorld->addRigidBody(body, record.group, record.mask);
+            }
+            else
+            {
+                this->dynamicsWorld->addCollisionObject(object, record.group, record.mask);
+            }
+        }
+        else if (wanted)
+        {
+            // Contacts cached for the old pose would push on the new one
+            this->overlappingPairCache->getOverlappingPairCache()->cleanProxyFromPairs(
+                object->getBroadphaseHandle(), this->dispatcher);
+            this->dynamicsWorld->updateSingleAabb(object);
+        }
+
+        object->forceActivationState(record.activation);
+        object->setDeactivationTime(record.deactivationTime);
+    }
+
+    return true;
+}
+
+bool BulletPhysics::saveState(const std::string& fileName)
+{
+    std::vector<char> buffer;
+    writeState(buffer);
+
+    std::ofstream file(fileName.c_str(), std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    file.write(&buffer[0], buffer.size());
+    return file.good();
+}
+
+bool BulletPhysics::loadState(const std::string& fileName)
+{
+    std::ifstream file(fileName.c_str(), std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::vector<char> buffer(size_t(file.tellg()));
+    file.seekg(0);
+    if (buffer.empty() || !file.read(&buffer[0], buffer.size()))
+    {
+        return false;
+    }
+
+    return readState(buffer);
+}
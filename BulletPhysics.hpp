@@ -4,29 +4,101 @@
 #include <btBulletDynamicsCommon.h>
 #include <BulletCollision/CollisionDispatch/btGhostObject.h>
 
+#include "ContactDispatcher.hpp"
+
 #include <vector>
 #include <string>
 #include <map>
 #include <iostream>
 
+#define PHYSICS_CONFIG_FILE "physics.cfg"
+#define PHYSICS_GRAVITY btVector3(0.0, -200.0, 0.0)
+#define PHYSICS_STATE_MAGIC 0x53574344 // "DCWS" in a little-endian file
+#define PHYSICS_STATE_VERSION 1
+
+// Collision filter groups, above the ones Bullet defines in btBroadphaseProxy
+enum CollisionGroup
+{
+  COL_WALL = 1 << 6,
+  COL_CAT = 1 << 7,
+  COL_PLAYER = 1 << 8,
+  COL_PADDLE = 1 << 9
+};
+
+// What each group collides with. The player's ghost ignores its own paddle.
+#define COL_WALL_MASK (COL_CAT | COL_PLAYER)
+#define COL_CAT_MASK (COL_WALL | COL_CAT | COL_PLAYER | COL_PADDLE)
+#define COL_PLAYER_MASK (COL_WALL | COL_CAT)
+#define COL_PADDLE_MASK (COL_CAT)
+
+class OgreMotionState;
+class btITaskScheduler;
+
+// How initObjects builds the dynamics world. The multithreaded world needs a
+// Bullet built with BT_THREADSAFE; without it the serial world is used.
+struct PhysicsConfig
+{
+  PhysicsConfig();
+  // Reads Key=Value lines, '#' starts a comment. False if the file is missing.
+  bool load(const std::string& fileName);
+
+  bool multithreaded;
+  int threads;            // task scheduler threads, 0 = one per core
+  int solvers;            // solvers in the pool, 0 = one per thread
+  int dispatcherGrain;    // manifolds per parallel dispatcher task
+  int manifoldPoolSize;   // preallocated contact manifolds
+  int maxSubSteps;        // fixed steps one frame may run, the rest are dropped
+};
+
 class BulletPhysics
 {
 private:
   btDefaultCollisionConfiguration* collisionConfiguration;
   btCollisionDispatcher* dispatcher;
   btBroadphaseInterface* overlappingPairCache;
-  btSequentialImpulseConstraintSolver* solver;
+  btConstraintSolver* solver;
+  btConstraintSolver* solverMt;
   btDiscreteDynamicsWorld* dynamicsWorld;
+  btITaskScheduler* taskScheduler; // installed globally while the Mt world lives
+  bool multithreaded;
+  int threadCount;
   std::vector<btCollisionShape *> collisionShape;
   std::map<std::string, btRigidBody *> physicsAccessors;
+  std::vector<OgreMotionState *> pendingSyncs;
+  std::vector<btCollisionObject *> stateObjects;
+  std::vector<OgreMotionState *> stateMotionStates;
+  ContactDispatcher contactDispatcher;
 public:
   BulletPhysics();
-  void initObjects();
+  ~BulletPhysics();
+  void initObjects(const PhysicsConfig& config = PhysicsConfig());
   btDiscreteDynamicsWorld* getDynamicsWorld();
   std::vector<btCollisionShape *>& getCollisionShapes();
   void trackRigidBodyWithName(btRigidBody* body, std::string& name);
   void trackRigidBodyWithName(btRigidBody* body, std::string&& name);
   size_t getCollisionObjectCount();
+  void queueMotionStateSync(OgreMotionState* state);
+  std::vector<OgreMotionState *>& getPendingSyncs();
+  ContactDispatcher& getContactDispatcher();
+  bool isMultithreaded();
+  int getThreadCount();
+
+  // Objects carried by world states, in the order they were tracked. Worlds
+  // built the same way track the same objects. state is the motion state
+  // that moves the object's node, if it has one.
+  void trackStateObject(btCollisionObject* object, OgreMotionState* state = 0);
+  size_t getStateObjectCount();
+  btCollisionObject* getStateObject(const size_t index);
+
+  // Pose, velocity, sleep state and world membership of every tracked
+  // object, in a versioned binary layout of native floats
+  void writeState(std::vector<char>& buffer);
+  // Puts the tracked objects back as the buffer describes and queues their
+  // nodes for a sync. Nothing changes when the buffer does not fit.
+  bool readState(const std::vector<char>& buffer);
+
+  bool saveState(const std::string& fileName);
+  bool loadState(const std::string& fileName);
 };
 
 std::ostream& operator << (std::ostream& out, const btVector3& vec);
@@ -0,0 +1,267 @@
+#include "Cat.hpp"
+#include "OgreMotionState.hpp"
+
+//---------------------------------------------------------------------------
+Cat::Cat(BulletPhysics* physics, Ogre::SceneManager* scnMgr, Player* player)
+	: mPhysicsEngine(physics),
+	mSceneMgr(scnMgr),
+	mPlayer(player),
+	mBody(0),
+	mMotionState(0),
+	mEntity(0),
+	mNode(0),
+	mCatNode(0),
+	mInstance(0),
+	mActive(false),
+	mAge(0.0f),
+	mRestTime(0.0f)
+{
+}
+
+//---------------------------------------------------------------------------
+Cat::~Cat()
+{
+    if (mActive)
+    {
+        retire();
+    }
+
+    detachNode();
+
+    if (mBody)
+    {
+        delete mMotionState;
+        delete mBody;
+    }
+
+    if (mNode)
+    {
+        mCatNode->detachAllObjects();
+        mSceneMgr->destroyEntity(mEntity);
+        mSceneMgr->destroySceneNode(mCatNode);
+        mSceneMgr->destroySceneNode(mNode);
+    }
+
+    if (mInstance)
+    {
+        mSceneMgr->destroyInstancedEntity(mInstance);
+    }
+}
+
+//---------------------------------------------------------------------------
+void Cat::initCatPhysics(const float catMass, btCollisionShape* shape)
+{
+    mTransform.setIdentity();
+
+    btScalar mass(catMass);
+    btVector3 localInertia(0, 0, 0);
+
+    mMotionState = new OgreMotionState(mTransform, 0, mPhysicsEngine);
+
+    shape->calculateLocalInertia(mass, localInertia);
+
+    btRigidBody::btRigidBodyConstructionInfo rigidBodyInfo(mass, mMotionState,
+    	shape, localInertia);
+    mBody = new btRigidBody(rigidBodyInfo);
+
+    mBody->setRestitution(1);
+
+    mPhysicsEngine->trackStateObject(mBody, mMotionState);
+}
+
+//---------------------------------------------------------------------------
+void Cat::setVelocity(const btVector3& direction)
+{
+    mPhysLookDir = direction;
+    mPhysLookDir.normalize();
+
+    mBody->setLinearVelocity(mPhysLookDir * CAT_SPEED);
+    mBody->setAngularVelocity(btVector3(0, 0, 0));
+}
+
+//---------------------------------------------------------------------------
+void Cat::initCatOgre(const Ogre::MeshPtr& mesh)
+{
+	mEntity = mSceneMgr->createEntity(mesh);
+    mEntity->setCastShadows(false);
+
+    // The node is created detached; attachNode() hooks it into the scene graph
+    mNode = mSceneMgr->createSceneNode();
+    mCatNode = mNode->createChildSceneNode();
+    mCatNode->attachObject(mEntity);
+    mMotionState->setNode(mNode);
+
+    mCatNode->scale(Ogre::Vector3(CAT_SCALE, CAT_SCALE, CAT_SCALE));
+    mCatNode->yaw(Ogre::Radian(Ogre::Degree(180)));
+    mCatNode->pitch(Ogre::Radian(Ogre::Degree(90)));
+}
+
+//---------------------------------------------------------------------------
+void Cat::initCatInstanced(Ogre::InstancedEntity* instance)
+{
+    mInstance = instance;
+    mInstance->setInUse(false);
+    mInstance->setScale(Ogre::Vector3(CAT_SCALE, CAT_SCALE, CAT_SCALE));
+
+    // Same turn initCatOgre gives the child node
+    Ogre::Quaternion yaw(Ogre::Degree(180), Ogre::Vector3::UNIT_Y);
+    Ogre::Quaternion pitch(Ogre::Degree(90), Ogre::Vector3::UNIT_X);
+    mMotionState->setInstance(mInstance, yaw * pitch);
+}
+
+//---------------------------------------------------------------------------
+void Cat::launch()
+{
+    // The Cat flies where the player's cannon points
+    btVector3 lookDir = mPlayer->getLookDirection();
+    lookDir.normalize();
+
+    btTransform transform = mPlayer->getWorldTransform();
+    btVector3 origin = transform.getOrigin();
+    btVector3 cannonOffset = lookDir.cross(btVector3(0, 1, 0));
+
+    // Set the physics position of the Cat
+    transform.setOrigin(origin + lookDir * SPAWN_DISTANCE
+        + cannonOffset * CANNON_OFFSET);
+
+    launchFrom(transform, lookDir);
+}
+
+//---------------------------------------------------------------------------
+void Cat::launchFrom(const btTransform& transform, const btVector3& direction)
+{
+    setVelocity(direction);
+
+    mTransform = transform;
+    mBody->setWorldTransform(mTransform);
+    mBody->setInterpolationWorldTransform(mTransform);
+    mMotionState->reset(mTransform);
+    mBody->clearForces();
+
+    mPhysicsEngine->getDynamicsWorld()->addRigidBody(mBody, COL_CAT, COL_CAT_MASK);
+    mBody->activate(true);
+
+    mActive = true;
+    mAge = 0.0f;
+    mRestTime = 0.0f;
+}
+
+//---------------------------------------------------------------------------
+void Cat::retire()
+{
+    mPhysicsEngine->getDynamicsWorld()->removeRigidBody(mBody);
+    mActive = false;
+}
+
+//---------------------------------------------------------------------------
+void Cat::restore()
+{
+    mActive = mBody->isInWorld();
+    mTransform = mBody->getWorldTransform();
+    mAge = 0.0f;
+    mRestTime = 0.0f;
+}
+
+//---------------------------------------------------------------------------
+void Cat::attachNode()
+{
+    if (mInstance)
+    {
+        mInstance->setInUse(true);
+    }
+
+    if (mNode && !mNode->getParentSceneNode())
+    {
+        mSceneMgr->getRootSceneNode()->addChild(mNode);
+    }
+}
+
+//---------------------------------------------------------------------------
+void Cat::detachNode()
+{
+    if (mInstance)
+    {
+        mInstance->setInUse(false);
+    }
+
+    if (mNode && mNode->getParentSceneNode())
+    {
+        mNode->getParentSceneNode()->removeChild(mNode);
+    }
+}
+
+//---------------------------------------------------------------------------
+void Cat::setVisible(const bool visible)
+{
+    if (mInstance)
+    {
+        mInstance->setVisible(visible);
+    }
+    else if (mEntity)
+    {
+        mEntity->setVisible(visible);
+    }
+}
+
+//---------------------------------------------------------------------------
+Ogre::Vector3 Cat::getRenderPosition() const
+{
+    if (mInstance)
+    {
+        return mInstance->getPosition();
+    }
+
+    return mNode ? mNode->getPosition() : Ogre::Vector3::ZERO;
+}
+
+//---------------------------------------------------------------------------
+void Cat::tick(const float dt, const float restSpeed)
+{
+    mAge += dt;
+
+    if (!mBody->isActive()
+        || mBody->getLinearVelocity().length2() < restSpeed * restSpeed)
+    {
+        mRestTime += dt;
+    }
+    else
+    {
+        mRestTime = 0.0f;
+    }
+}
+
+//---------------------------------------------------------------------------
+bool Cat::isActive() const
+{
+    return mActive;
+}
+
+//---------------------------------------------------------------------------
+float Cat::getAge() const
+{
+    return mAge;
+}
+
+//---------------------------------------------------------------------------
+float Cat::getRestTime() const
+{
+    return mRestTime;
+}
+
+//---------------------------------------------------------------------------
+btRigidBody* Cat::getBody()
+{
+    return mBody;
+}
+
+//---------------------------------------------------------------------------
+Ogre::SceneNode* Cat::getSceneNode()
+{
+    return mNode;
+}
+
+//---------------------------------------------------------------------------
+Ogre::Entity* Cat::getEntity()
+{
+    return mEntity;
+}
@@ -5,120 +5,79 @@
 #include "Player.hpp"
 
 #include <OgreEntity.h>
+#include <OgreInstancedEntity.h>
 #include <OgreSceneManager.h>
 #include <OgreVector3.h>
 #include <OgreMeshManager.h>
 
+class OgreMotionState;
+
 #define SPAWN_DISTANCE 150.0f
+#define CANNON_OFFSET 55.0f
 #define CAT_SPEED 2000
+#define CAT_SCALE 100.0f
 
 class Cat
 {
 public:
     Cat(BulletPhysics*, Ogre::SceneManager*, Player* player);
-
-    void initCatPhysics(const float catMass, const float sphereSize);
-    void setVelocity();
-    void initCatOgre(const char* meshName);
+    ~Cat();
+
+    // Builds the rigid body around a shape that is shared by every cat
+    void initCatPhysics(const float catMass, btCollisionShape* shape);
+    void initCatOgre(const Ogre::MeshPtr& mesh);
+    // Draws the cat as one instance of a shared batch instead of an entity
+    void initCatInstanced(Ogre::InstancedEntity* instance);
+
+    // Puts the cat in front of the cannon and adds it to the world (physics thread)
+    void launch();
+    // Same, from any pose, for benchmarks and replays with no player
+    void launchFrom(const btTransform& transform, const btVector3& direction);
+    // Takes the cat out of the world so it can be reused (physics thread)
+    void retire();
+    // Follows the body after a world state was loaded. The age and rest
+    // time are not part of the state and start over.
+    void restore();
+
+    // Shows or hides the cat's scene node or instance (render thread)
+    void attachNode();
+    void detachNode();
+    // Hides a cat still in play, for distance culling (render thread)
+    void setVisible(const bool visible);
+    // Where the cat was last drawn (render thread)
+    Ogre::Vector3 getRenderPosition() const;
+
+    // Advances the cat's age and how long it has been moving slower than restSpeed
+    void tick(const float dt, const float restSpeed);
+
+    bool isActive() const;
+    float getAge() const;
+    float getRestTime() const;
+    btRigidBody* getBody();
+    Ogre::SceneNode* getSceneNode();
+    Ogre::Entity* getEntity();
 
 private:
+    void setVelocity(const btVector3& direction);
+
 	BulletPhysics* mPhysicsEngine;
 	Ogre::SceneManager* mSceneMgr;
 	Player* mPlayer;
 
 	btRigidBody* mBody;
+	OgreMotionState* mMotionState;
+
+	Ogre::Entity* mEntity;
+	Ogre::SceneNode* mNode;
+	Ogre::SceneNode* mCatNode;
+	Ogre::InstancedEntity* mInstance;
+
+	bool mActive;
+	float mAge;
+	float mRestTime;
 
 	btVector3 mPhysLookDir;
-	btVector3 mVector;
 	btTransform mTransform;
 };
 
 #endif
-
-//---------------------------------------------------------------------------
-Cat::Cat(BulletPhysics* physics, Ogre::SceneManager* scnMgr, Player* player)
-	: mPhysicsEngine(physics),
-	mSceneMgr(scnMgr),
-	mPlayer(player),
-	mBody(0)
-{
-}
-
-//---------------------------------------------------------------------------
-void Cat::initCatPhysics(const float catMass, const float sphereSize)
-{
-	mTransform = mPlayer->getWorldTransform();
-    mVector = mTransform.getOrigin();
-
-    btScalar mass(catMass);
-    btVector3 localInertia(0, 0, 0);
-
-    btCollisionShape* shape = new btSphereShape(sphereSize);
-    mPhysicsEngine->getCollisionShapes().push_back(shape);
-    btDefaultMotionState* motionState = new btDefaultMotionState(mTransform);
-
-    shape->calculateLocalInertia(mass, localInertia);
-
-    btRigidBody::btRigidBodyConstructionInfo rigidBodyInfo(mass, motionState, 
-    	shape, localInertia);
-    mBody = new btRigidBody(rigidBodyInfo);
-    mPhysicsEngine->getDynamicsWorld()->addRigidBody(mBody);
-
-    mBody->setRestitution(1);
-}
-
-//---------------------------------------------------------------------------
-void Cat::setVelocity()
-{
-	 // Set the velocity of the Cat based on sight and camera nodes attached to the player
-    Ogre::Vector3 direction = mPlayer->getOgreLookDirection();
-
-    btVector3 temp(direction.x, direction.y, direction.z);
-    mPhysLookDir = temp;
-    mPhysLookDir.normalize();
-
-    mBody->setLinearVelocity(mPhysLookDir * CAT_SPEED);
-}
-
-//---------------------------------------------------------------------------
-void Cat::initCatOgre(const char* meshName)
-{
-    static bool meshCreated = false;
-    if (!meshCreated)
-    {
-      Ogre::MeshManager::getSingleton().create(meshName,
-                Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
-      meshCreated = true;
-    }
-
-	Ogre::Entity* entity = mSceneMgr->createEntity(Ogre::MeshManager::getSingleton()
-        .getByName(meshName, Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME));
-    entity->setCastShadows(false);
-
-    Ogre::SceneNode* node = mSceneMgr->getRootSceneNode()->createChildSceneNode();
-    Ogre::SceneNode* catNode = node->createChildSceneNode();
-    catNode->attachObject(entity);
-    mBody->setUserPointer(node);
-
-    Ogre::Vector3 lookDir = Ogre::Vector3(mPhysLookDir.x(), mPhysLookDir.y(), mPhysLookDir.z());
-    Ogre::Vector3 nodePos = Ogre::Vector3(mVector.x(), mVector.y(), mVector.z());
-    Ogre::Vector3 up(0, 1, 0);
-
-    Ogre::Vector3 cannonOffset = lookDir.crossProduct(up);
-
-    nodePos += lookDir * SPAWN_DISTANCE + cannonOffset * 55;
-    node->setPosition(nodePos);
-
-    // Set the physics position of the Cat
-    mTransform.setOrigin(mVector + mPhysLookDir * SPAWN_DISTANCE 
-        + btVector3(cannonOffset.x, cannonOffset.y, cannonOffset.z) * 55);
-    mBody->setWorldTransform(mTransform);
-
-    btQuaternion q = mTransform.getRotation();
-    node->setOrientation(Ogre::Quaternion(q.w(), q.x(), q.y(), q.z()));
-
-    Ogre::Real catScale = 100.0;
-    catNode->scale(Ogre::Vector3(catScale, catScale, catScale));
-    catNode->yaw(Ogre::Radian(Ogre::Degree(180)));
-    catNode->pitch(Ogre::Radian(Ogre::Degree(90)));
-}
@@ -0,0 +1,113 @@
+#include "CatDespawner.hpp"
+
+//---------------------------------------------------------------------------
+CatLifetimePolicy::CatLifetimePolicy()
+    : timeToLive(CAT_TIME_TO_LIVE),
+    restSpeed(CAT_REST_SPEED),
+    restTime(CAT_REST_TIME),
+    maxLive(CAT_MAX_LIVE),
+    playMin(-800.0f, -100.0f, -800.0f),
+    playMax(800.0f, 6100.0f, 800.0f)
+{
+}
+
+//---------------------------------------------------------------------------
+CatDespawner::CatDespawner(CatPool* pool, const CatLifetimePolicy& policy)
+    : mPool(pool),
+    mPolicy(policy),
+    mExpired(0),
+    mRested(0),
+    mEscaped(0),
+    mEvicted(0)
+{
+}
+
+//---------------------------------------------------------------------------
+void CatDespawner::update(const float dt)
+{
+    const std::vector<Cat*>& live = mPool->getLiveCats();
+
+    mDoomed.clear();
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        Cat* cat = live[i];
+        cat->tick(dt, mPolicy.restSpeed);
+
+        if (cat->getAge() >= mPolicy.timeToLive)
+        {
+            ++mExpired;
+        }
+        else if (cat->getRestTime() >= mPolicy.restTime)
+        {
+            ++mRested;
+        }
+        else if (!isInPlay(cat))
+        {
+            ++mEscaped;
+        }
+        else
+        {
+            continue;
+        }
+
+        mDoomed.push_back(cat);
+    }
+
+    for (size_t i = 0; i < mDoomed.size(); ++i)
+    {
+        mPool->release(mDoomed[i]);
+    }
+
+    // Live cats are kept oldest first
+    while (mPool->getLiveCount() > mPolicy.maxLive)
+    {
+        mPool->release(live.front());
+        ++mEvicted;
+    }
+}
+
+//---------------------------------------------------------------------------
+bool CatDespawner::isInPlay(Cat* cat) const
+{
+    const btVector3& pos = cat->getBody()->getWorldTransform().getOrigin();
+
+    return pos.x() >= mPolicy.playMin.x() && pos.x() <= mPolicy.playMax.x()
+        && pos.y() >= mPolicy.playMin.y() && pos.y() <= mPolicy.playMax.y()
+        && pos.z() >= mPolicy.playMin.z() && pos.z() <= mPolicy.playMax.z();
+}
+
+//---------------------------------------------------------------------------
+CatLifetimePolicy& CatDespawner::getPolicy()
+{
+    return mPolicy;
+}
+
+//---------------------------------------------------------------------------
+size_t CatDespawner::getLiveCount() const
+{
+    return mPool->getLiveCount();
+}
+
+//---------------------------------------------------------------------------
+size_t CatDespawner::getExpired() const
+{
+    return mExpired;
+}
+
+//---------------------------------------------------------------------------
+size_t CatDespawner::getRested() const
+{
+    return mRested;
+}
+
+//---------------------------------------------------------------------------
+size_t CatDespawner::getEscaped() const
+{
+    return mEscaped;
+}
+
+//---------------------------------------------------------------------------
+size_t CatDespawner::getEvicted() const
+{
+    return mEvicted;
+}
@@ -0,0 +1,59 @@
+#ifndef CatDespawner_hpp
+#define CatDespawner_hpp
+
+#include "CatPool.hpp"
+
+#include <btBulletDynamicsCommon.h>
+
+#include <vector>
+
+#define CAT_TIME_TO_LIVE 20.0f
+#define CAT_REST_SPEED 15.0f
+#define CAT_REST_TIME 2.0f
+#define CAT_MAX_LIVE 64
+
+struct CatLifetimePolicy
+{
+    CatLifetimePolicy();
+
+    float timeToLive; // Seconds a cat stays in play at most
+    float restSpeed; // Below this speed a cat counts as resting
+    float restTime; // Seconds of rest before a cat is removed
+    size_t maxLive; // Oldest cats are evicted above this count
+    btVector3 playMin; // Cats outside this box have left the arena
+    btVector3 playMax;
+};
+
+// Retires cats that expired, came to rest or left the arena, and evicts the
+// oldest ones when too many are live, so the dynamics world stays bounded.
+class CatDespawner
+{
+public:
+    CatDespawner(CatPool* pool, const CatLifetimePolicy& policy = CatLifetimePolicy());
+
+    // Called once per physics step
+    void update(const float dt);
+
+    CatLifetimePolicy& getPolicy();
+
+    size_t getLiveCount() const;
+    size_t getExpired() const;
+    size_t getRested() const;
+    size_t getEscaped() const;
+    size_t getEvicted() const;
+
+private:
+    bool isInPlay(Cat* cat) const;
+
+    CatPool* mPool;
+    CatLifetimePolicy mPolicy;
+
+    std::vector<Cat*> mDoomed;
+
+    size_t mExpired;
+    size_t mRested;
+    size_t mEscaped;
+    size_t mEvicted;
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "CatPool.hpp"
+
+#include <OgreRoot.h>
+
+#include <algorithm>
+
+//---------------------------------------------------------------------------
+CatPool::CatPool(BulletPhysics* physics, Ogre::SceneManager* sceneMgr, Player* player,
+    const char* meshName, size_t capacity, bool instanced)
+    : mPhysicsEngine(physics),
+    mSceneMgr(sceneMgr),
+    mPlayer(player),
+    mShape(0),
+    mInstanceManager(0),
+    mCapacity(capacity),
+    mHits(0),
+    mMisses(0),
+    mRecycled(0),
+    mHighWater(0)
+{
+    mShape = new btSphereShape(CAT_RADIUS);
+    mPhysicsEngine->getCollisionShapes().push_back(mShape);
+
+    if (mSceneMgr)
+    {
+        mMesh = Ogre::MeshManager::getSingleton().load(meshName,
+            Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+    }
+
+    const Ogre::RenderSystemCapabilities* caps = mSceneMgr
+        ? Ogre::Root::getSingleton().getRenderSystem()->getCapabilities() : 0;
+
+    if (instanced && caps && caps->hasCapability(Ogre::RSC_VERTEX_BUFFER_INSTANCE_DATA))
+    {
+        mInstanceManager = mSceneMgr->createInstanceManager(CAT_INSTANCE_MANAGER, meshName,
+            Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
+            Ogre::InstanceManager::HWInstancingBasic, CAT_INSTANCES_PER_BATCH);
+        mInstanceManager->setSetting(Ogre::InstanceManager::CAST_SHADOWS, false);
+    }
+
+    mCats.reserve(mCapacity);
+    mFree.reserve(mCapacity);
+    mLive.reserve(mCapacity);
+}
+
+//---------------------------------------------------------------------------
+CatPool::~CatPool()
+{
+    for (size_t i = 0; i < mCats.size(); ++i)
+    {
+        delete mCats[i];
+    }
+
+    if (mInstanceManager)
+    {
+        mSceneMgr->destroyInstanceManager(mInstanceManager);
+    }
+}
+
+//---------------------------------------------------------------------------
+Cat* CatPool::build()
+{
+    Cat* cat = new Cat(mPhysicsEngine, mSceneMgr, mPlayer);
+    cat->initCatPhysics(CAT_MASS, mShape);
+
+    if (mInstanceManager)
+    {
+        cat->initCatInstanced(mSceneMgr->createInstancedEntity(CAT_INSTANCE_MATERIAL,
+            CAT_INSTANCE_MANAGER));
+    }
+    else if (mSceneMgr)
+    {
+        cat->initCatOgre(mMesh);
+    }
+
+    mCats.push_back(cat);
+    return cat;
+}
+
+//---------------------------------------------------------------------------
+Cat* CatPool::acquire()
+{
+    Cat* cat = 0;
+
+    if (!mFree.empty())
+    {
+        cat = mFree.back();
+        mFree.pop_back();
+        ++mHits;
+    }
+    else if (mCats.size() < mCapacity)
+    {
+        cat = build();
+        ++mMisses;
+    }
+    else if (!mLive.empty())
+    {
+        // Pool exhausted, steal the oldest cat still in play
+        cat = mLive.front();
+        mLive.erase(mLive.begin());
+        cat->retire();
+        ++mRecycled;
+
+        CatEvent retired = { cat, false };
+        mEvents.push_back(retired);
+    }
+    else
+    {
+        return 0;
+    }
+
+    cat->launch();
+    mLive.push_back(cat);
+    mHighWater = std::max(mHighWater, mLive.size());
+
+    CatEvent launched = { cat, true };
+    mEvents.push_back(launched);
+
+    return cat;
+}
+
+//---------------------------------------------------------------------------
+void CatPool::release(Cat* cat)
+{
+    std::vector<Cat*>::iterator it = std::find(mLive.begin(), mLive.end(), cat);
+    if (it == mLive.end())
+    {
+        return;
+    }
+
+    mLive.erase(it);
+    cat->retire();
+    mFree.push_back(cat);
+
+    CatEvent retired = { cat, false };
+    mEvents.push_back(retired);
+}
+
+//---------------------------------------------------------------------------
+void CatPool::prewarm()
+{
+    while (mCats.size() < mCapacity)
+    {
+        mFree.push_back(build());
+    }
+}
+
+//---------------------------------------------------------------------------
+void CatPool::syncWithWorld()
+{
+    mLive.clear();
+    mFree.clear();
+
+    for (size_t i = 0; i < mCats.size(); ++i)
+    {
+        Cat* cat = mCats[i];
+        cat->restore();
+
+        if (cat->isActive())
+        {
+            mLive.push_back(cat);
+        }
+        else
+        {
+            mFree.push_back(cat);
+        }
+
+        CatEvent event = { cat, cat->isActive() };
+        mEvents.push_back(event);
+    }
+
+    mHighWater = std::max(mHighWater, mLive.size());
+}
+
+//---------------------------------------------------------------------------
+void CatPool::takeEvents(std::vector<CatEvent>& events)
+{
+    events.insert(events.end(), mEvents.begin(), mEvents.end());
+    mEvents.clear();
+}
+
+//---------------------------------------------------------------------------
+const std::vector<Cat*>& CatPool::getLiveCats() const
+{
+    return mLive;
+}
+
+//---------------------------------------------------------------------------
+size_t CatPool::getCapacity() const
+{
+    return mCapacity;
+}
+
+//---------------------------------------------------------------------------
+size_t CatPool::getLiveCount() const
+{
+    return mLive.size();
+}
+
+//---------------------------------------------------------------------------
+size_t CatPool::getHits() const
+{
+    return mHits;
+}
+
+//---------------------------------------------------------------------------
+size_t CatPool::getMisses() const
+{
+    return mMisses;
+}
+
+//---------------------------------------------------------------------------
+size_t CatPool::getRecycled() const
+{
+    return mRecycled;
+}
+
+//---------------------------------------------------------------------------
+size_t CatPool::getHighWater() const
+{
+    return mHighWater;
+}
+
+//---------------------------------------------------------------------------
+bool CatPool::isInstanced() const
+{
+    return mInstanceManager != 0;
+}
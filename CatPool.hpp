@@ -0,0 +1,91 @@
+#ifndef CatPool_hpp
+#define CatPool_hpp
+
+#include "BulletPhysics.hpp"
+#include "Cat.hpp"
+#include "Player.hpp"
+
+#include <OgreInstanceManager.h>
+#include <OgreSceneManager.h>
+#include <OgreMeshManager.h>
+
+#include <vector>
+
+#define CAT_POOL_CAPACITY 256
+#define CAT_MASS 10.0f
+#define CAT_RADIUS 20.0f
+#define CAT_INSTANCE_MATERIAL "Cat/Instanced"
+#define CAT_INSTANCE_MANAGER "CatInstances"
+#define CAT_INSTANCES_PER_BATCH 128
+
+// A cat entering or leaving play, so the render side can show or hide its node
+struct CatEvent
+{
+    Cat* cat;
+    bool launched;
+};
+
+// Fixed-capacity pool of cats. Every cat shares one sphere shape and one mesh,
+// and retired cats keep their body and scene nodes so they can be re-armed.
+// Instanced, the cats are hardware instances of CAT_INSTANCE_MATERIAL drawn
+// CAT_INSTANCES_PER_BATCH to a batch, with no scene nodes of their own; when
+// the render system cannot instance, each cat gets an entity as before.
+class CatPool
+{
+public:
+    CatPool(BulletPhysics* physics, Ogre::SceneManager* sceneMgr, Player* player,
+        const char* meshName, size_t capacity = CAT_POOL_CAPACITY, bool instanced = false);
+    ~CatPool();
+
+    // Launches a cat from the cannon. Reuses a retired cat when one is free,
+    // builds a new one while under capacity, and otherwise recycles the oldest
+    // live cat.
+    Cat* acquire();
+    void release(Cat* cat);
+
+    // Builds every cat up front so acquire() never creates Ogre objects.
+    // Required before cats are acquired off the render thread.
+    void prewarm();
+
+    // Moves the launch and retire events since the last call into events
+    void takeEvents(std::vector<CatEvent>& events);
+
+    // Rebuilds the live and free lists from the cats' bodies after a world
+    // state was loaded, with an event for every cat
+    void syncWithWorld();
+
+    // Live cats, oldest first
+    const std::vector<Cat*>& getLiveCats() const;
+
+    size_t getCapacity() const;
+    size_t getLiveCount() const;
+    size_t getHits() const;
+    size_t getMisses() const;
+    size_t getRecycled() const;
+    size_t getHighWater() const;
+    bool isInstanced() const;
+
+private:
+    Cat* build();
+
+    BulletPhysics* mPhysicsEngine;
+    Ogre::SceneManager* mSceneMgr;
+    Player* mPlayer;
+
+    btCollisionShape* mShape;
+    Ogre::MeshPtr mMesh;
+    Ogre::InstanceManager* mInstanceManager;
+
+    size_t mCapacity;
+    std::vector<Cat*> mCats;
+    std::vector<Cat*> mFree;
+    std::vector<Cat*> mLive;
+    std::vector<CatEvent> mEvents;
+
+    size_t mHits;
+    size_t mMisses;
+    size_t mRecycled;
+    size_t mHighWater;
+};
+
+#endif
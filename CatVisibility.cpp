@@ -0,0 +1,76 @@
+#include "CatVisibility.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+//---------------------------------------------------------------------------
+CatVisibility::CatVisibility(const float drawDistance, const size_t lodLevels)
+    : mDrawDistance(drawDistance),
+    mLodCounts(std::max(lodLevels, size_t(1)), 0),
+    mCulled(0)
+{
+}
+
+//---------------------------------------------------------------------------
+void CatVisibility::show(Cat* cat)
+{
+    if (std::find(mShown.begin(), mShown.end(), cat) == mShown.end())
+    {
+        mShown.push_back(cat);
+    }
+
+    cat->setVisible(true);
+}
+
+//---------------------------------------------------------------------------
+void CatVisibility::hide(Cat* cat)
+{
+    std::vector<Cat*>::iterator it = std::find(mShown.begin(), mShown.end(), cat);
+    if (it != mShown.end())
+    {
+        mShown.erase(it);
+    }
+}
+
+//---------------------------------------------------------------------------
+void CatVisibility::update(const Ogre::Vector3& camera)
+{
+    const float limit = mDrawDistance * mDrawDistance;
+
+    std::fill(mLodCounts.begin(), mLodCounts.end(), 0);
+    mCulled = 0;
+
+    for (size_t i = 0; i < mShown.size(); ++i)
+    {
+        Cat* cat = mShown[i];
+
+        bool visible = mDrawDistance <= 0
+            || cat->getRenderPosition().squaredDistance(camera) <= limit;
+        cat->setVisible(visible);
+
+        if (!visible)
+        {
+            ++mCulled;
+            continue;
+        }
+
+        // Instances have no entity and always draw the full mesh
+        size_t lod = cat->getEntity() ? cat->getEntity()->getCurrentLodIndex() : 0;
+        ++mLodCounts[std::min(lod, mLodCounts.size() - 1)];
+    }
+}
+
+//---------------------------------------------------------------------------
+std::string CatVisibility::summary() const
+{
+    std::ostringstream out;
+    out << "cat lod:";
+
+    for (size_t i = 0; i < mLodCounts.size(); ++i)
+    {
+        out << (i == 0 ? " " : " / ") << mLodCounts[i];
+    }
+
+    out << ", culled: " << mCulled;
+    return out.str();
+}
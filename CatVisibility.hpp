@@ -0,0 +1,36 @@
+#ifndef CatVisibility_hpp
+#define CatVisibility_hpp
+
+#include "Cat.hpp"
+
+#include <OgreVector3.h>
+
+#include <string>
+#include <vector>
+
+// Render side list of the cats in play, fed by the pool's launch and retire
+// events. Hides the cats past the draw distance and counts how many were
+// drawn at each level of detail, for the stats HUD.
+class CatVisibility
+{
+public:
+    // drawDistance 0 never hides a cat
+    CatVisibility(const float drawDistance, const size_t lodLevels);
+
+    void show(Cat* cat);
+    void hide(Cat* cat);
+
+    // Once a frame, with the camera's world position
+    void update(const Ogre::Vector3& camera);
+
+    std::string summary() const;
+
+private:
+    float mDrawDistance;
+
+    std::vector<Cat*> mShown;
+    std::vector<size_t> mLodCounts; // Cats drawn at each level last frame
+    size_t mCulled;
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include "ContactDispatcher.hpp"
+
+#include <algorithm>
+
+ContactDispatcher* ContactDispatcher::sInstalled = 0;
+
+//---------------------------------------------------------------------------
+ContactDispatcher::ContactDispatcher()
+    : mDispatched(0)
+{
+}
+
+//---------------------------------------------------------------------------
+ContactDispatcher::~ContactDispatcher()
+{
+    uninstall();
+}
+
+//---------------------------------------------------------------------------
+void ContactDispatcher::install()
+{
+    sInstalled = this;
+    gContactStartedCallback = &ContactDispatcher::contactStarted;
+    gContactEndedCallback = &ContactDispatcher::contactEnded;
+}
+
+//---------------------------------------------------------------------------
+void ContactDispatcher::uninstall()
+{
+    if (sInstalled != this)
+    {
+        return;
+    }
+
+    sInstalled = 0;
+    gContactStartedCallback = 0;
+    gContactEndedCallback = 0;
+}
+
+//---------------------------------------------------------------------------
+void ContactDispatcher::addListener(const int groupA, const int groupB,
+    ContactListener* listener)
+{
+    Subscription subscription = { groupA, groupB, listener };
+    mListeners.push_back(subscription);
+}
+
+//---------------------------------------------------------------------------
+void ContactDispatcher::removeListener(ContactListener* listener)
+{
+    for (size_t i = 0; i < mListeners.size(); )
+    {
+        if (mListeners[i].listener == listener)
+        {
+            mListeners.erase(mListeners.begin() + i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+void ContactDispatcher::contactStarted(btPersistentManifold* const& manifold)
+{
+    if (sInstalled)
+    {
+        sInstalled->queue(manifold, true);
+    }
+}
+
+//---------------------------------------------------------------------------
+void ContactDispatcher::contactEnded(btPersistentManifold* const& manifold)
+{
+    if (sInstalled)
+    {
+        sInstalled->queue(manifold, false);
+    }
+}
+
+//---------------------------------------------------------------------------
+bool ContactDispatcher::isWanted(const int groupA, const int groupB) const
+{
+    for (size_t i = 0; i < mListeners.size(); ++i)
+    {
+        const Subscription& s = mListeners[i];
+
+        if (((s.groupA & groupA) && (s.groupB & groupB)) ||
+            ((s.groupA & groupB) && (s.groupB & groupA)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//---------------------------------------------------------------------------
+void ContactDispatcher::queue(btPersistentManifold* manifold, const bool began)
+{
+    const btCollisionObject* objectA = manifold->getBody0();
+    const btCollisionObject* objectB = manifold->getBody1();
+
+    // Objects still have their proxies while their contacts are cleaned up
+    int groupA = objectA->getBroadphaseHandle() ? objectA->getBroadphaseHandle()->m_collisionFilterGroup : 0;
+    int groupB = objectB->getBroadphaseHandle() ? objectB->getBroadphaseHandle()->m_collisionFilterGroup : 0;
+
+    if (!isWanted(groupA, groupB))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (!began)
+    {
+        // The manifold may be freed once its contact ended
+        for (size_t i = 0; i < mPending.size(); ++i)
+        {
+            if (mPending[i].manifold == manifold)
+            {
+                mPending[i].manifold = 0;
+            }
+        }
+    }
+
+    PendingContact contact = { began ? manifold : 0, objectA, objectB, groupA, groupB, began };
+    mPending.push_back(contact);
+}
+
+//---------------------------------------------------------------------------
+void ContactDispatcher::dispatch()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDispatching.swap(mPending);
+    }
+
+    for (size_t i = 0; i < mDispatching.size(); ++i)
+    {
+        const PendingContact& contact = mDispatching[i];
+
+        ContactEvent event;
+        event.began = contact.began;
+        event.impulse = 0;
+        event.point = btVector3(0, 0, 0);
+
+        if (contact.manifold && contact.manifold->getNumContacts() > 0)
+        {
+            event.point = contact.manifold->getContactPoint(0).getPositionWorldOnA();
+
+            for (int p = 0; p < contact.manifold->getNumContacts(); ++p)
+            {
+                event.impulse = std::max(event.impulse,
+                    contact.manifold->getContactPoint(p).getAppliedImpulse());
+            }
+        }
+
+        for (size_t j = 0; j < mListeners.size(); ++j)
+        {
+            const Subscription& s = mListeners[j];
+
+            if ((s.groupA & contact.groupA) && (s.groupB & contact.groupB))
+            {
+                event.objectA = contact.objectA;
+                event.objectB = contact.objectB;
+            }
+            else if ((s.groupA & contact.groupB) && (s.groupB & contact.groupA))
+            {
+                event.objectA = contact.objectB;
+                event.objectB = contact.objectA;
+            }
+            else
+            {
+                continue;
+            }
+
+            s.listener->onContact(event);
+            ++mDispatched;
+        }
+    }
+
+    mDispatching.clear();
+}
+
+//---------------------------------------------------------------------------
+unsigned long ContactDispatcher::getDispatchedCount() const
+{
+    return mDispatched;
+}
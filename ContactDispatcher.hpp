@@ -0,0 +1,88 @@
+#ifndef ContactDispatcher_hpp
+#define ContactDispatcher_hpp
+
+#include <btBulletDynamicsCommon.h>
+
+#include <mutex>
+#include <vector>
+
+// A contact that started or ended between two collision objects. objectA
+// belongs to the first group the listener subscribed with.
+struct ContactEvent
+{
+    const btCollisionObject* objectA;
+    const btCollisionObject* objectB;
+    bool began;
+    btScalar impulse; // Largest impulse the solver applied, begin events only
+    btVector3 point; // World position of the contact, begin events only
+};
+
+class ContactListener
+{
+public:
+    virtual ~ContactListener() {}
+    virtual void onContact(const ContactEvent& event) = 0;
+};
+
+// Turns Bullet's global contact started and ended callbacks into events for
+// listeners that asked for a pair of collision groups. Only matching contacts
+// are queued, so a step full of cat on cat bounces costs nothing here.
+// Callbacks may arrive from the multithreaded dispatcher; dispatch() runs on
+// the thread that steps the world.
+class ContactDispatcher
+{
+public:
+    ContactDispatcher();
+    ~ContactDispatcher();
+
+    // Routes Bullet's callbacks to this dispatcher. There is one set of
+    // callbacks per process, so only one dispatcher is installed at a time.
+    void install();
+    void uninstall();
+
+    // Contacts between an object of groupA and one of groupB go to listener
+    void addListener(const int groupA, const int groupB, ContactListener* listener);
+    void removeListener(ContactListener* listener);
+
+    // Delivers the contacts queued since the last call. Call right after
+    // stepSimulation, while the manifolds of this step are still alive.
+    void dispatch();
+
+    unsigned long getDispatchedCount() const;
+
+private:
+    struct Subscription
+    {
+        int groupA;
+        int groupB;
+        ContactListener* listener;
+    };
+
+    struct PendingContact
+    {
+        const btPersistentManifold* manifold; // Cleared if the manifold goes away first
+        const btCollisionObject* objectA;
+        const btCollisionObject* objectB;
+        int groupA;
+        int groupB;
+        bool began;
+    };
+
+    static void contactStarted(btPersistentManifold* const& manifold);
+    static void contactEnded(btPersistentManifold* const& manifold);
+
+    void queue(btPersistentManifold* manifold, const bool began);
+    bool isWanted(const int groupA, const int groupB) const;
+
+    static ContactDispatcher* sInstalled;
+
+    std::vector<Subscription> mListeners;
+
+    std::mutex mMutex;
+    std::vector<PendingContact> mPending;
+    std::vector<PendingContact> mDispatching;
+
+    unsigned long mDispatched;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#include "ContactSounds.hpp"
+
+#include <algorithm>
+
+//---------------------------------------------------------------------------
+static bool isLouder(const SoundEvent& a, const SoundEvent& b)
+{
+    return a.impulse > b.impulse;
+}
+
+//---------------------------------------------------------------------------
+ContactSounds::ContactSounds(BulletPhysics* physics)
+    : mPhysicsEngine(physics),
+    mTime(0.0f),
+    mHeard(0),
+    mQuiet(0),
+    mCooling(0)
+{
+    ContactDispatcher& dispatcher = mPhysicsEngine->getContactDispatcher();
+    dispatcher.addListener(COL_CAT, COL_WALL, this);
+    dispatcher.addListener(COL_CAT, COL_PADDLE, this);
+    dispatcher.addListener(COL_CAT, COL_CAT, this);
+}
+
+//---------------------------------------------------------------------------
+ContactSounds::~ContactSounds()
+{
+    mPhysicsEngine->getContactDispatcher().removeListener(this);
+}
+
+//---------------------------------------------------------------------------
+void ContactSounds::update(const float dt)
+{
+    mTime += dt;
+
+    if (mStep.size() > CONTACT_SOUNDS_PER_STEP)
+    {
+        std::partial_sort(mStep.begin(), mStep.begin() + CONTACT_SOUNDS_PER_STEP,
+            mStep.end(), isLouder);
+        mStep.resize(CONTACT_SOUNDS_PER_STEP);
+    }
+
+    mHeard += mStep.size();
+    mEvents.insert(mEvents.end(), mStep.begin(), mStep.end());
+    mStep.clear();
+}
+
+//---------------------------------------------------------------------------
+bool ContactSounds::isCooling(const btCollisionObject* source) const
+{
+    std::unordered_map<const btCollisionObject*, float>::const_iterator it =
+        mLastPlayed.find(source);
+
+    return it != mLastPlayed.end() && mTime - it->second < CONTACT_SOUND_COOLDOWN;
+}
+
+//---------------------------------------------------------------------------
+void ContactSounds::onContact(const ContactEvent& event)
+{
+    if (!event.began)
+    {
+        return;
+    }
+
+    if (event.impulse < CONTACT_SOUND_MIN_IMPULSE)
+    {
+        ++mQuiet;
+        return;
+    }
+
+    // objectA is always a cat; in a cat on cat contact both are
+    bool catPair = event.objectB->getBroadphaseHandle() &&
+        (event.objectB->getBroadphaseHandle()->m_collisionFilterGroup & COL_CAT);
+
+    if (isCooling(event.objectA) || (catPair && isCooling(event.objectB)))
+    {
+        ++mCooling;
+        return;
+    }
+
+    mLastPlayed[event.objectA] = mTime;
+    if (catPair)
+    {
+        mLastPlayed[event.objectB] = mTime;
+    }
+
+    // The cat is the emitter, the contact point can be unset
+    SoundEvent sound = { SOUND_MEOW, event.objectA->getWorldTransform().getOrigin(), event.impulse };
+    mStep.push_back(sound);
+}
+
+//---------------------------------------------------------------------------
+void ContactSounds::takeEvents(std::vector<SoundEvent>& events)
+{
+    events.insert(events.end(), mEvents.begin(), mEvents.end());
+    mEvents.clear();
+}
+
+//---------------------------------------------------------------------------
+unsigned long ContactSounds::getHeard() const
+{
+    return mHeard;
+}
+
+//---------------------------------------------------------------------------
+unsigned long ContactSounds::getQuiet() const
+{
+    return mQuiet;
+}
+
+//---------------------------------------------------------------------------
+unsigned long ContactSounds::getCooling() const
+{
+    return mCooling;
+}
@@ -0,0 +1,61 @@
+#ifndef ContactSounds_hpp
+#define ContactSounds_hpp
+
+#include "BulletPhysics.hpp"
+#include "ContactDispatcher.hpp"
+#include "SoundId.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+#define CONTACT_SOUND_MIN_IMPULSE 500.0f // Softer contacts are silent
+#define CONTACT_SOUND_COOLDOWN 0.5f // Seconds before the same cat sounds again
+#define CONTACT_SOUNDS_PER_STEP 4 // Loudest contacts kept from one step
+
+// A sound the render side should play, from a contact the physics side saw
+struct SoundEvent
+{
+    SoundId effect;
+    btVector3 position; // Of the cat that made it
+    btScalar impulse;
+};
+
+// Listens for cats hitting walls, the paddle and each other, and turns the
+// hard ones into sound events. Each cat has a cooldown and each step keeps
+// only its loudest few, so a pile of cats cannot flood the mixer.
+// Physics side; the events are handed to the render side with the snapshot.
+class ContactSounds : public ContactListener
+{
+public:
+    ContactSounds(BulletPhysics* physics);
+    ~ContactSounds();
+
+    // Advances the cooldown clock and trims this step's events, once per step
+    void update(const float dt);
+
+    void onContact(const ContactEvent& event);
+
+    // Moves the events since the last call into events
+    void takeEvents(std::vector<SoundEvent>& events);
+
+    unsigned long getHeard() const;
+    unsigned long getQuiet() const;
+    unsigned long getCooling() const;
+
+private:
+    bool isCooling(const btCollisionObject* source) const;
+
+    BulletPhysics* mPhysicsEngine;
+
+    float mTime;
+    std::unordered_map<const btCollisionObject*, float> mLastPlayed;
+
+    std::vector<SoundEvent> mStep;
+    std::vector<SoundEvent> mEvents;
+
+    unsigned long mHeard; // Handed to the render side
+    unsigned long mQuiet;
+    unsigned long mCooling;
+};
+
+#endif
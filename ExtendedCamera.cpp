@@ -1,5 +1,31 @@
 #include "ExtendedCamera.hpp"
 
+#include <cmath>
+
+// Critically damped spring from current towards goal (Game Programming
+// Gems 4, 1.10). The exact solution rather than the book's polynomial for
+// the decay, so while the goal holds still the result does not depend on
+// how elapsedTime is sliced up.
+static Ogre::Vector3 springTowards (const Ogre::Vector3& current, const Ogre::Vector3& goal,
+    Ogre::Vector3& velocity, Ogre::Real smoothTime, Ogre::Real elapsedTime)
+{
+    if (smoothTime <= 0)
+    {
+        velocity = Ogre::Vector3::ZERO;
+        return goal;
+    }
+
+    Ogre::Real omega = 2.0f / smoothTime;
+    Ogre::Real x = omega * elapsedTime;
+    Ogre::Real decay = std::exp(-x);
+
+    Ogre::Vector3 change = current - goal;
+    Ogre::Vector3 temp = (velocity + change * omega) * elapsedTime;
+    velocity = (velocity - temp * omega) * decay;
+
+    return goal + (change + temp) * decay;
+}
+
 ExtendedCamera::ExtendedCamera (Ogre::String name, Ogre::SceneManager *sceneMgr, Ogre::Camera *camera) 
 {
     // Basic member references setup
@@ -29,8 +55,11 @@ ExtendedCamera::ExtendedCamera (Ogre::String name, Ogre::SceneManager *sceneMgr,
     mCameraNode->attachObject (mCamera);
     mCameraNode->setPosition(Ogre::Vector3(0.0, 1000.0, 0.0));
 
-    // Default tightness
-    mTightness = 0.08f;
+    // About what the old fixed 0.08 per frame felt like at 60 fps
+    mSmoothTime = 0.2f;
+    mLookahead = 0.0f;
+    mCameraVelocity = Ogre::Vector3::ZERO;
+    mTargetVelocity = Ogre::Vector3::ZERO;
 }
 ExtendedCamera::~ExtendedCamera () 
 {
@@ -46,14 +75,34 @@ Ogre::Vector3 ExtendedCamera::getCameraPosition ()
     return mCameraNode->getPosition ();
 }
 
-void ExtendedCamera::update (Ogre::Real elapsedTime, Ogre::Vector3 cameraPosition, Ogre::Vector3 targetPosition) 
+Ogre::Vector3 ExtendedCamera::getCameraRight () 
+{
+    return mCamera->getDerivedRight ();
+}
+
+void ExtendedCamera::update (Ogre::Real elapsedTime, Ogre::Vector3 cameraPosition, Ogre::Vector3 targetPosition,
+    Ogre::Vector3 velocity) 
 {
-    // Handle movement
-    Ogre::Vector3 displacement;
+    if (elapsedTime <= 0)
+    {
+        return;
+    }
+
+    // Look where the followed object is heading
+    targetPosition += velocity * mLookahead;
 
-    displacement = (cameraPosition - mCameraNode->getPosition ()) * mTightness;
-    mCameraNode->translate (displacement);
+    mCameraNode->setPosition (springTowards (mCameraNode->getPosition (), cameraPosition,
+        mCameraVelocity, mSmoothTime, elapsedTime));
+    mTargetNode->setPosition (springTowards (mTargetNode->getPosition (), targetPosition,
+        mTargetVelocity, mSmoothTime, elapsedTime));
+}
 
-    displacement = (targetPosition - mTargetNode->getPosition ()) * mTightness;
-    mTargetNode->translate (displacement);
+void ExtendedCamera::setSmoothTime (Ogre::Real smoothTime)
+{
+    mSmoothTime = smoothTime;
+}
+
+void ExtendedCamera::setLookahead (Ogre::Real lookahead)
+{
+    mLookahead = lookahead;
 }
@@ -10,8 +10,18 @@ public:
     ~ExtendedCamera ();
 
     Ogre::Vector3 getCameraPosition ();
+    // World space right vector of the camera, for panning sounds
+    Ogre::Vector3 getCameraRight ();
 
-    void update (Ogre::Real elapsedTime, Ogre::Vector3 cameraPosition, Ogre::Vector3 targetPosition);
+    // Springs the camera and its target towards the given positions over
+    // elapsedTime seconds. velocity is the followed object's, for lookahead.
+    void update (Ogre::Real elapsedTime, Ogre::Vector3 cameraPosition, Ogre::Vector3 targetPosition,
+        Ogre::Vector3 velocity = Ogre::Vector3::ZERO);
+
+    // Seconds the spring takes to mostly catch up, the same at any frame rate
+    void setSmoothTime (Ogre::Real smoothTime);
+    // Seconds of the followed object's velocity the target leads by
+    void setLookahead (Ogre::Real lookahead);
 
 protected:
     Ogre::SceneNode *mTargetNode; // The camera target
@@ -23,7 +33,11 @@ protected:
 
     bool mOwnCamera; // To know if the ogre camera binded has been created outside or inside of this class
 
-    Ogre::Real mTightness; // Determines the movement of the camera - 1 means tight movement, while 0 means no movement
+    Ogre::Real mSmoothTime; // Critically damped spring time, 0 snaps straight to the goal
+    Ogre::Real mLookahead;
+
+    Ogre::Vector3 mCameraVelocity; // Spring state of each node
+    Ogre::Vector3 mTargetVelocity;
 };
 
 #endif
@@ -0,0 +1,106 @@
+#include "FixedTimestep.hpp"
+
+#include <algorithm>
+
+//---------------------------------------------------------------------------
+FixedTimestep::FixedTimestep(const double step, const int maxSubSteps)
+    : mStep(step),
+    mMaxSubSteps(maxSubSteps),
+    mAccumulator(0.0),
+    mTotalSteps(0),
+    mDroppedSteps(0),
+    mLastStepTime(0.0),
+    mAverageStepTime(0.0),
+    mMaxStepTime(0.0)
+{
+}
+
+//---------------------------------------------------------------------------
+int FixedTimestep::advance(const double frameTime)
+{
+    mAccumulator += frameTime;
+
+    int steps = static_cast<int>(mAccumulator / mStep);
+    if (steps > mMaxSubSteps)
+    {
+        // Fall behind gracefully instead of spiralling
+        mDroppedSteps += steps - mMaxSubSteps;
+        mAccumulator -= (steps - mMaxSubSteps) * mStep;
+        steps = mMaxSubSteps;
+    }
+
+    mAccumulator -= steps * mStep;
+    mTotalSteps += steps;
+
+    return steps;
+}
+
+//---------------------------------------------------------------------------
+double FixedTimestep::getAlpha() const
+{
+    return std::min(1.0, std::max(0.0, mAccumulator / mStep));
+}
+
+//---------------------------------------------------------------------------
+double FixedTimestep::getStep() const
+{
+    return mStep;
+}
+
+//---------------------------------------------------------------------------
+void FixedTimestep::setMaxSubSteps(const int maxSubSteps)
+{
+    mMaxSubSteps = std::max(1, maxSubSteps);
+}
+
+//---------------------------------------------------------------------------
+int FixedTimestep::getMaxSubSteps() const
+{
+    return mMaxSubSteps;
+}
+
+//---------------------------------------------------------------------------
+void FixedTimestep::recordStepTime(const double milliseconds)
+{
+    mLastStepTime = milliseconds;
+    mMaxStepTime = std::max(mMaxStepTime, milliseconds);
+
+    if (mAverageStepTime == 0.0)
+    {
+        mAverageStepTime = milliseconds;
+    }
+    else
+    {
+        mAverageStepTime += (milliseconds - mAverageStepTime) * 0.05;
+    }
+}
+
+//---------------------------------------------------------------------------
+unsigned long FixedTimestep::getTotalSteps() const
+{
+    return mTotalSteps;
+}
+
+//---------------------------------------------------------------------------
+unsigned long FixedTimestep::getDroppedSteps() const
+{
+    return mDroppedSteps;
+}
+
+//---------------------------------------------------------------------------
+double FixedTimestep::getLastStepTime() const
+{
+    return mLastStepTime;
+}
+
+//---------------------------------------------------------------------------
+double FixedTimestep::getAverageStepTime() const
+{
+    return mAverageStepTime;
+}
+
+//---------------------------------------------------------------------------
+double FixedTimestep::getMaxStepTime() const
+{
+    return mMaxStepTime;
+}
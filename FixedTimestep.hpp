@@ -0,0 +1,48 @@
+#ifndef FixedTimestep_hpp
+#define FixedTimestep_hpp
+
+#define PHYSICS_STEP (1.0 / 60.0)
+#define PHYSICS_MAX_SUBSTEPS 5 // Unless physics.cfg sets MaxSubSteps
+
+// Accumulates frame time and hands it out in fixed physics steps. Anything
+// beyond maxSubSteps in one frame is dropped so a slow frame cannot make the
+// next one slower. The leftover fraction of a step is the interpolation
+// factor between the last two physics states.
+class FixedTimestep
+{
+public:
+    FixedTimestep(const double step = PHYSICS_STEP, const int maxSubSteps = PHYSICS_MAX_SUBSTEPS);
+
+    // Adds the frame time and returns how many steps to run this frame
+    int advance(const double frameTime);
+
+    // How far between the previous and current physics states rendering is, in [0, 1)
+    double getAlpha() const;
+    double getStep() const;
+
+    void setMaxSubSteps(const int maxSubSteps);
+    int getMaxSubSteps() const;
+
+    void recordStepTime(const double milliseconds);
+
+    unsigned long getTotalSteps() const;
+    unsigned long getDroppedSteps() const;
+    double getLastStepTime() const;
+    double getAverageStepTime() const;
+    double getMaxStepTime() const;
+
+private:
+    double mStep;
+    int mMaxSubSteps;
+    double mAccumulator;
+
+    unsigned long mTotalSteps;
+    unsigned long mDroppedSteps;
+
+    // Milliseconds spent in stepSimulation
+    double mLastStepTime;
+    double mAverageStepTime;
+    double mMaxStepTime;
+};
+
+#endif
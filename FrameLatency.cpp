@@ -0,0 +1,87 @@
+#include "FrameLatency.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+//---------------------------------------------------------------------------
+FrameLatency::FrameLatency()
+    : mFrameStarts(FRAME_LATENCY_HISTORY, 0.0),
+    mNext(0),
+    mCount(0),
+    mLastInput(0.0),
+    mLast(0),
+    mMax(0),
+    mAverage(0.0),
+    mSamples(0)
+{
+}
+
+//---------------------------------------------------------------------------
+void FrameLatency::frameStarted(const double time)
+{
+    mFrameStarts[mNext] = time;
+    mNext = (mNext + 1) % mFrameStarts.size();
+    mCount = std::min(mCount + 1, mFrameStarts.size());
+}
+
+//---------------------------------------------------------------------------
+void FrameLatency::shown(const double inputTime)
+{
+    // Each input is measured once, at the first frame that shows it
+    if (inputTime <= mLastInput || mCount == 0)
+    {
+        return;
+    }
+    mLastInput = inputTime;
+
+    // Frames begun after the input, newest first, plus the one it arrived in
+    int frames = 1;
+    for (size_t i = 1; i <= mCount; ++i)
+    {
+        size_t index = (mNext + mFrameStarts.size() - i) % mFrameStarts.size();
+        if (mFrameStarts[index] <= inputTime)
+        {
+            break;
+        }
+        ++frames;
+    }
+
+    mLast = frames;
+    mMax = std::max(mMax, frames);
+    mAverage = mSamples == 0 ? frames : mAverage + (frames - mAverage) * 0.05;
+    ++mSamples;
+}
+
+//---------------------------------------------------------------------------
+int FrameLatency::getLast() const
+{
+    return mLast;
+}
+
+//---------------------------------------------------------------------------
+int FrameLatency::getMax() const
+{
+    return mMax;
+}
+
+//---------------------------------------------------------------------------
+double FrameLatency::getAverage() const
+{
+    return mAverage;
+}
+
+//---------------------------------------------------------------------------
+unsigned long FrameLatency::getSamples() const
+{
+    return mSamples;
+}
+
+//---------------------------------------------------------------------------
+std::string FrameLatency::summary() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << "input to photon: "
+        << mAverage << " frames avg, " << mLast << " last, " << mMax << " max";
+    return out.str();
+}
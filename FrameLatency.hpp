@@ -0,0 +1,43 @@
+#ifndef FrameLatency_hpp
+#define FrameLatency_hpp
+
+#include <string>
+#include <vector>
+
+#define FRAME_LATENCY_HISTORY 16 // Frame start times kept, deeper input is clamped
+
+// Counts the frames from an input event to the first presented frame that
+// shows its effect. 1 means the input reached the very next present.
+// Times are seconds on the input clock. Render thread only.
+class FrameLatency
+{
+public:
+    FrameLatency();
+
+    // Marks the start of the frame being built
+    void frameStarted(const double time);
+
+    // Input that happened at inputTime is in the frame being built
+    void shown(const double inputTime);
+
+    int getLast() const;
+    int getMax() const;
+    double getAverage() const;
+    unsigned long getSamples() const;
+
+    // One line, for the HUD
+    std::string summary() const;
+
+private:
+    std::vector<double> mFrameStarts;
+    size_t mNext;
+    size_t mCount;
+    double mLastInput;
+
+    int mLast;
+    int mMax;
+    double mAverage;
+    unsigned long mSamples;
+};
+
+#endif
@@ -1,4 +1,8 @@
 #include "GameManager.hpp"
+#include "HeadlessRunner.hpp"
+
+#include <cstdlib>
+#include <ctime>
 
 //---------------------------------------------------------------------------
 GameManager::GameManager()
@@ -8,20 +12,36 @@ GameManager::GameManager()
     mCamera(0),
     mExCamera(0),
     mPlayer(0),
+    mCatPool(0),
+    mCatDespawner(0),
+    mCatVisibility(0),
 
     mPhysicsEngine(0),
+    mSimulation(0),
+    mContactSounds(0),
+    mPhysicsThread(0),
+    mPhysicsThreaded(true),
+    mMaxSubSteps(PHYSICS_MAX_SUBSTEPS),
+    mStaticWalls(true),
+    mInstancedCats(true),
 
     mInputMgr(0),
     mMouse(0),
     mKeyboard(0),
 
     mSound(0),
+    mSpatialAudio(0),
 
     mShutDown(false),
     mScore(0),
 
-    mTimeSinceLastPhysicsStep(0),
     mTimeSinceLastCat(0),
+    mSyncedNodeCount(0),
+    mCameraElapsed(0),
+    mAverageFrameTime(0),
+    mAverageRenderWork(0),
+    mShowProfiler(false),
+    mProfilerHudCountdown(0),
 
     mState(MAIN_MENU),
     mRenderer(0)
@@ -34,6 +54,45 @@ GameManager::~GameManager()
   // Remove ourself as a Window listener
   Ogre::WindowEventUtilities::removeWindowEventListener(mWindow, this);
   windowClosed(mWindow);
+
+  if (mPhysicsThread)
+  {
+    mPhysicsThread->stop();
+    logPhysicsStats();
+
+    if (!mRecordFile.empty())
+    {
+      if (mRecording.save(mRecordFile))
+      {
+        Ogre::LogManager::getSingletonPtr()->logMessage("*** Input recording of "
+          + Ogre::StringConverter::toString(mRecording.getStepCount()) + " steps written to "
+          + mRecordFile + " ***");
+      }
+      else
+      {
+        Ogre::LogManager::getSingletonPtr()->logMessage("*** Could not write " + mRecordFile + " ***");
+      }
+    }
+    delete mPhysicsThread;
+    delete mSimulation;
+    delete mContactSounds;
+  }
+
+  if (!mProfileDumpFile.empty())
+  {
+    mProfiler.dump(mProfileDumpFile);
+  }
+
+  if (mCatPool)
+  {
+    logCatPoolStats();
+    delete mCatDespawner;
+    delete mCatVisibility;
+    delete mCatPool;
+  }
+
+  delete mSpatialAudio;
+  delete mSound;
   delete mRoot;
 }
 
@@ -45,6 +104,13 @@ bool GameManager::go()
         return false;
     }
 
+    if (!mLevel.load())
+    {
+        Ogre::LogManager::getSingletonPtr()->logMessage(std::string("*** Could not load level ")
+            + LEVEL_FILE + " ***");
+        return false;
+    }
+
     initBullet();
 
     initInput();
@@ -55,8 +121,29 @@ bool GameManager::go()
     mRenderer = &CEGUI::OgreRenderer::bootstrapSystem();
     initGUI();
 
-    // mSound = new Sound();
-    // mSound->initSound();
+    loadAssets();
+
+    // Replays run with the seed they were recorded with, which only picks
+    // the sound samples; the steps replay the same without it
+    if (!mReplayFile.empty())
+    {
+        if (!mRecording.load(mReplayFile))
+        {
+            Ogre::LogManager::getSingletonPtr()->logMessage("*** Could not read input recording "
+                + mReplayFile + " ***");
+            return false;
+        }
+    }
+    else
+    {
+        mRecording.setSeed(uint32_t(std::time(0)));
+    }
+    std::srand(mRecording.getSeed());
+
+    // Audio loads in the background while the menu is up
+    mSound = new Sound();
+    mSound->initSound();
+    mSpatialAudio = new SpatialAudio(mSound);
 
     // This starts the rendering loop
     // We don't need any special handling of the loop since we can
@@ -66,6 +153,48 @@ bool GameManager::go()
     return true;
 }
 
+//---------------------------------------------------------------------------
+void GameManager::setPhysicsThreaded(const bool threaded)
+{
+    mPhysicsThreaded = threaded;
+}
+
+//---------------------------------------------------------------------------
+void GameManager::setProfileDump(const std::string& fileName)
+{
+    mProfileDumpFile = fileName;
+}
+
+//---------------------------------------------------------------------------
+void GameManager::setRecordFile(const std::string& fileName)
+{
+    mRecordFile = fileName;
+}
+
+//---------------------------------------------------------------------------
+void GameManager::setReplayFile(const std::string& fileName)
+{
+    mReplayFile = fileName;
+}
+
+//---------------------------------------------------------------------------
+void GameManager::setStateFile(const std::string& fileName)
+{
+    mStateFile = fileName;
+}
+
+//---------------------------------------------------------------------------
+void GameManager::setStaticWalls(const bool batched)
+{
+    mStaticWalls = batched;
+}
+
+//---------------------------------------------------------------------------
+void GameManager::setInstancedCats(const bool instanced)
+{
+    mInstancedCats = instanced;
+}
+
 //---------------------------------------------------------------------------
 bool GameManager::initOgre()
 {
@@ -94,13 +223,49 @@ bool GameManager::initOgre()
   return true;
 }
 
+//---------------------------------------------------------------------------
+// The loading phase: everything a spawn could need is read and compiled here,
+// before the menu shows, instead of on the first frame that uses it
+void GameManager::loadAssets()
+{
+    mGraphicsConfig.load(GRAPHICS_CONFIG_FILE);
+
+    mAssets.addMesh("Cat.mesh");
+    mAssets.addMesh("cannon/CannonBase.mesh");
+    mAssets.addMesh("cannon/CannonSpray.mesh");
+    mAssets.addMaterial("Examples/Rockwall");
+    if (mInstancedCats)
+    {
+        mAssets.addMaterial(CAT_INSTANCE_MATERIAL);
+    }
+
+    mAssets.preload();
+
+    std::ostringstream stats;
+    stats << "*** Asset cache: " << mAssets.getMeshCount() << " meshes, "
+          << mAssets.getMaterialCount() << " materials loaded, "
+          << mAssets.getFailures() << " failed ***";
+    Ogre::LogManager::getSingletonPtr()->logMessage(stats.str());
+
+    // Detail levels must exist before any entity is made from the meshes
+    mGraphicsConfig.applyLod(mAssets.getMesh("Cat.mesh"));
+    mGraphicsConfig.applyLod(mAssets.getMesh("cannon/CannonBase.mesh"));
+    mGraphicsConfig.applyLod(mAssets.getMesh("cannon/CannonSpray.mesh"));
+}
+
 //---------------------------------------------------------------------------
 void GameManager::initBullet()
 {
     // Setup Bullet physics
+    PhysicsConfig config;
+    config.load(PHYSICS_CONFIG_FILE);
+
     mPhysicsEngine = new BulletPhysics();
-    mPhysicsEngine->initObjects();
-    mPhysicsEngine->getDynamicsWorld()->setGravity(btVector3(0.0, -200.0, 0.0));
+    mPhysicsEngine->initObjects(config);
+    mPhysicsEngine->getDynamicsWorld()->setGravity(PHYSICS_GRAVITY);
+
+    // Applied to the physics loop once it exists
+    mMaxSubSteps = config.maxSubSteps;
 }
 
 //---------------------------------------------------------------------------
@@ -132,54 +297,53 @@ void GameManager::initInput()
 //---------------------------------------------------------------------------
 void GameManager::initScene()
 {
-    // Add ambient light
-    mSceneMgr->setAmbientLight(Ogre::ColourValue(0.25, 0.25, 0.25));
-    mSceneMgr->setShadowTechnique(Ogre::SHADOWTYPE_STENCIL_ADDITIVE);
+    mGraphicsConfig.applyShadows(mSceneMgr);
 
-    mPlayer = new Player("Player 1", mSceneMgr, mPhysicsEngine, mSound);
-
-    // Add a point light
-    Ogre::Light* light = mSceneMgr->createLight("MainLight");
-    light->setDiffuseColour(1.0, 1.0, 1.0);
-    light->setSpecularColour(1.0, 1.0, 1.0);
-    light->setDirection(Ogre::Vector3(0.0, -1.0, 0.0));
-    light->setType(Ogre::Light::LT_DIRECTIONAL);
+    mExCamera->setSmoothTime(mGraphicsConfig.cameraSmoothTime);
+    mExCamera->setLookahead(mGraphicsConfig.cameraLookahead);
 
-    std::vector<Wall*> walls;
-    for (int i = 0; i < 6; ++i)
+    mPlayer = new Player("Player 1", mSceneMgr, mPhysicsEngine, mSound);
+    mCatPool = new CatPool(mPhysicsEngine, mSceneMgr, mPlayer, "Cat.mesh", CAT_POOL_CAPACITY,
+        mInstancedCats);
+    CatLifetimePolicy policy;
+    policy.playMin = mLevel.getPlayMin();
+    policy.playMax = mLevel.getPlayMax();
+    mCatDespawner = new CatDespawner(mCatPool, policy);
+    mCatVisibility = new CatVisibility(mGraphicsConfig.catDrawDistance,
+        mCatPool->isInstanced() ? 1 : mGraphicsConfig.lodSteps.size() + 1);
+
+    mContactSounds = new ContactSounds(mPhysicsEngine);
+    mSimulation = new Simulation(mPhysicsEngine, mPlayer, mCatPool, mCatDespawner, mContactSounds);
+    mPhysicsThread = new PhysicsThread(mSimulation, mPhysicsEngine, mCatPool, mPlayer);
+    mPhysicsThread->getTimestep().setMaxSubSteps(mMaxSubSteps);
+
+    if (!mReplayFile.empty())
     {
-        walls.push_back(new Wall(mPhysicsEngine, mSceneMgr));
+        mPhysicsThread->setReplay(&mRecording);
+    }
+    else if (!mRecordFile.empty())
+    {
+        mPhysicsThread->setRecorder(&mRecording);
     }
 
-    // Ground
-    walls[0]->createWall("ground", 0.0f, 0.0f, 0.0f, 1500.0f, 1500.0f, 
-        Ogre::Vector3::UNIT_Y, Ogre::Vector3::UNIT_Z);
-    walls[0]->createGroundPhysics(0.0f, 0.0f, 0.0f);
-
-    // Left Wall
-    walls[1]->createWall("left wall", -750.0f, 3000.0f, 0.0f, 6000.0f, 1500.0f, 
-        Ogre::Vector3::UNIT_X, Ogre::Vector3::UNIT_Z);
-    walls[1]->createWallPhysics(-750.0f, 3000.0f, 0.0f, 5.0f, 6000.0f, 1500.0f);
-
-    // Right Wall
-    walls[2]->createWall("right wall", 750.0f, 3000.0f, 0.0f, 6000.0f, 1500.0f, 
-        Ogre::Vector3::NEGATIVE_UNIT_X, Ogre::Vector3::UNIT_Z);
-    walls[2]->createWallPhysics(750.0f, 3000.0f, 0.0f, 5.0f, 6000.0f, 1500.0f);
+    // Walls, ground, ceiling and lights come from the level
+    Arena arena(mPhysicsEngine, mSceneMgr, mLevel, mStaticWalls);
+    arena.build();
 
-    // Front Wall
-    walls[3]->createWall("front wall", 0.0f, 3000.0f, -750.0f, 6000.0f, 1500.0f, 
-        Ogre::Vector3::UNIT_Z, Ogre::Vector3::UNIT_X);
-    walls[3]->createWallPhysics(0.0f, 3000.0f, -750.0f, 1500.0f, 6000.0f, 5.0f);
+    // Every cat body exists up front, which saved states rely on too
+    mCatPool->prewarm();
 
-    // Back Wall
-    walls[4]->createWall("back wall", 0.0f, 3000.0f, 750.0f, 6000.0f, 1500.0f, 
-        Ogre::Vector3::NEGATIVE_UNIT_Z, Ogre::Vector3::UNIT_X);
-    walls[4]->createWallPhysics(0.0f, 3000.0f, 750.0f, 1500.0f, 6000.0f, 5.0f);
+    if (mPhysicsThreaded)
+    {
+        // From here on the physics thread owns the dynamics world
+        mPhysicsThread->start();
+    }
 
-    // Ceiling
-    walls[5]->createWall("ceiling", 0.0f, 6000.0f, 0.0f, 1500.0f, 1500.0f, 
-        Ogre::Vector3::NEGATIVE_UNIT_Y, Ogre::Vector3::UNIT_X);
-    walls[5]->createWallPhysics(0.0f, 6000.0f, 0.0f, 1500.0f, 5.0f, 1500.0f);
+    if (!mStateFile.empty() && !mPhysicsThread->loadState(mStateFile))
+    {
+        Ogre::LogManager::getSingletonPtr()->logMessage("*** Could not load world state "
+            + mStateFile + " ***");
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -218,8 +382,11 @@ void GameManager::initGUI()
     CEGUI::Window* title = wmgr.createWindow("TaharezLook/Label", "CEGUIDemo/MainTitle");
 
     CEGUI::Window* scoreBoard = wmgr.createWindow("TaharezLook/StaticText", "CEGUIDemo/scoreBoard"); 
+    CEGUI::Window* profileBoard = wmgr.createWindow("TaharezLook/StaticText", "CEGUIDemo/profileBoard");
 
-    start->setText("Start");
+    // Enabled once the audio has loaded behind the menu
+    start->setText("Loading...");
+    start->setEnabled(false);
     start->setSize(CEGUI::USize(CEGUI::UDim(0.15,0), CEGUI::UDim(0.05,0)));
     start->setPosition(CEGUI::UVector2(CEGUI::UDim(0.4f,0),CEGUI::UDim(0.4f,0)));
 
@@ -235,6 +402,10 @@ void GameManager::initGUI()
     scoreBoard->setSize(CEGUI::USize(CEGUI::UDim(0.15,0), CEGUI::UDim(0.05,0)));
     scoreBoard->setPosition(CEGUI::UVector2(CEGUI::UDim(0.05f,0),CEGUI::UDim(0.05f,0)));
 
+    profileBoard->setSize(CEGUI::USize(CEGUI::UDim(0.2,0), CEGUI::UDim(0.25,0)));
+    profileBoard->setPosition(CEGUI::UVector2(CEGUI::UDim(0.05f,0),CEGUI::UDim(0.11f,0)));
+    profileBoard->setVisible(false);
+
     quitMain->subscribeEvent(CEGUI::PushButton::EventClicked, CEGUI::Event::Subscriber(&GameManager::quit, this));
 
     start->subscribeEvent(CEGUI::PushButton::EventClicked, CEGUI::Event::Subscriber(&GameManager::start, this));
@@ -243,6 +414,7 @@ void GameManager::initGUI()
     startButtons.push_back(quitMain);
 
     mPlayButtons.push_back(scoreBoard);
+    mPlayButtons.push_back(profileBoard);
 
     mainSheet->addChild(start);
     mainSheet->addChild(quitMain);
@@ -250,6 +422,7 @@ void GameManager::initGUI()
 
 
     playSheet->addChild(scoreBoard);
+    playSheet->addChild(profileBoard);
 
     sheets.push_back(mainSheet);
     sheets.push_back(quitSheet);
@@ -315,10 +488,94 @@ void GameManager::initOgreViewports()
 //---------------------------------------------------------------------------
 void GameManager::spawnCat()
 {
-    Cat cat(mPhysicsEngine, mSceneMgr, mPlayer);
-    cat.initCatPhysics(10.0f, 20.0f);
-    cat.setVelocity();
-    cat.initCatOgre("Cat.mesh");
+    PlayerCommand cmd = mLastCommand;
+    cmd.spawnCat = true;
+    // No input behind a timed spawn: applied at once and never timed
+    cmd.time = 0.0;
+    mPhysicsThread->pushCommand(cmd);
+}
+
+//---------------------------------------------------------------------------
+void GameManager::logPhysicsStats()
+{
+    FixedTimestep& timestep = mPhysicsThread->getTimestep();
+
+    std::ostringstream stats;
+    stats << "*** Physics " << (mPhysicsThreaded ? "thread" : "inline") << " ("
+          << (mPhysicsEngine->isMultithreaded() ? "multithreaded world, " : "serial world, ")
+          << mPhysicsEngine->getThreadCount() << " solver threads): "
+          << timestep.getTotalSteps() << " steps, "
+          << timestep.getDroppedSteps() << " dropped, step time avg "
+          << timestep.getAverageStepTime() << " ms, max "
+          << timestep.getMaxStepTime() << " ms, loop busy avg "
+          << mPhysicsThread->getSnapshot().averageBusyTime << " ms, "
+          << mPhysicsThread->getDroppedCommands() << " dropped commands ***";
+    Ogre::LogManager::getSingletonPtr()->logMessage(stats.str());
+
+    std::ostringstream input;
+    input << "*** Input: latency to the physics step avg "
+          << mPhysicsThread->getSnapshot().averageInputLatency << " ms, "
+          << mInputBuffer.getDropped() << " events dropped, " << mFrameLatency.summary()
+          << " over " << mFrameLatency.getSamples() << " samples ***";
+    Ogre::LogManager::getSingletonPtr()->logMessage(input.str());
+
+    std::ostringstream sounds;
+    sounds << "*** Contact sounds: " << mContactSounds->getHeard() << " sent, "
+           << mContactSounds->getQuiet() << " too soft, "
+           << mContactSounds->getCooling() << " cooling down, "
+           << mSpatialAudio->getStarted() << " played, "
+           << mSpatialAudio->getStolen() << " cut off by louder ones, "
+           << mSpatialAudio->getCulled() << " too faint to play, "
+           << mSpatialAudio->getDropped() << " failed to play ***";
+    Ogre::LogManager::getSingletonPtr()->logMessage(sounds.str());
+
+    std::ostringstream render;
+    render << "*** Render thread: frame time avg " << mAverageFrameTime
+           << " ms, frame work avg " << mAverageRenderWork << " ms, "
+           << mWindow->getStatistics().batchCount << " batches last frame ("
+           << (mStaticWalls ? "static" : "unbatched") << " walls, "
+           << (mCatPool->isInstanced() ? "instanced" : "entity") << " cats) ***";
+    Ogre::LogManager::getSingletonPtr()->logMessage(render.str());
+}
+
+//---------------------------------------------------------------------------
+void GameManager::logCatPoolStats()
+{
+    std::ostringstream stats;
+    stats << "*** Cat pool: capacity " << mCatPool->getCapacity()
+          << ", live " << mCatPool->getLiveCount()
+          << ", high-water " << mCatPool->getHighWater()
+          << ", hits " << mCatPool->getHits()
+          << ", misses " << mCatPool->getMisses()
+          << ", recycled " << mCatPool->getRecycled() << " ***";
+    Ogre::LogManager::getSingletonPtr()->logMessage(stats.str());
+
+    std::ostringstream despawns;
+    despawns << "*** Cat despawns: expired " << mCatDespawner->getExpired()
+             << ", rested " << mCatDespawner->getRested()
+             << ", escaped " << mCatDespawner->getEscaped()
+             << ", evicted " << mCatDespawner->getEvicted() << " ***";
+    Ogre::LogManager::getSingletonPtr()->logMessage(despawns.str());
+}
+
+//---------------------------------------------------------------------------
+void GameManager::updateProfilerHud()
+{
+    if (!mShowProfiler || --mProfilerHudCountdown > 0)
+    {
+        return;
+    }
+
+    mProfilerHudCountdown = PROFILER_HUD_INTERVAL;
+    // Batches are draw calls; compare against --unbatched-walls
+    const Ogre::RenderTarget::FrameStats& stats = mWindow->getStatistics();
+    std::ostringstream hud;
+    hud << mProfiler.summary() << "\nbatches: " << stats.batchCount
+        << ", triangles: " << stats.triangleCount
+        << "\n" << mCatVisibility->summary()
+        << "\n" << mFrameLatency.summary();
+
+    mPlayButtons.at(1)->setText(hud.str());
 }
 
 // ---------------------Adjust mouse clipping area---------------------------
@@ -370,6 +627,42 @@ bool GameManager::keyPressed(const OIS::KeyEvent& ke)
     {
         mSound->muteUnmuteEffects();
     }
+    else if (ke.key == OIS::KC_F3 && mState == PLAY)
+    {
+        mShowProfiler = !mShowProfiler;
+        mProfilerHudCountdown = 0;
+        mPlayButtons.at(1)->setVisible(mShowProfiler);
+    }
+    else if (ke.key == OIS::KC_F4)
+    {
+        std::string fileName = mProfileDumpFile.empty() ? PROFILER_DUMP_FILE : mProfileDumpFile;
+        if (mProfiler.dump(fileName))
+        {
+            Ogre::LogManager::getSingletonPtr()->logMessage("*** Frame profile written to " + fileName + " ***");
+        }
+    }
+    else if (ke.key == OIS::KC_F5 && mState == PLAY)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool saved = mPhysicsThread->saveState(PHYSICS_CHECKPOINT_FILE);
+        Ogre::LogManager::getSingletonPtr()->logMessage(std::string("*** World state ")
+            + (saved ? "saved to " : "could not be saved to ") + PHYSICS_CHECKPOINT_FILE + " in "
+            + Ogre::StringConverter::toString(Ogre::Real(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count())) + " ms ***");
+    }
+    else if (ke.key == OIS::KC_F9 && mState == PLAY)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool loaded = mPhysicsThread->loadState(PHYSICS_CHECKPOINT_FILE);
+        Ogre::LogManager::getSingletonPtr()->logMessage(std::string("*** World state ")
+            + (loaded ? "loaded from " : "could not be loaded from ") + PHYSICS_CHECKPOINT_FILE + " in "
+            + Ogre::StringConverter::toString(Ogre::Real(std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count())) + " ms ***");
+    }
+    else if (mState == PLAY)
+    {
+        mInputBuffer.pushKey(ke.key, true);
+    }
 
     return true;
 }
@@ -378,6 +671,10 @@ bool GameManager::keyPressed(const OIS::KeyEvent& ke)
 bool GameManager::keyReleased(const OIS::KeyEvent& ke)
 {
     // CEGUI::System::getSingleton().getDefaultGUIContext().injectKeyUp((CEGUI::Key::Scan)ke.key);
+    if (mState == PLAY)
+    {
+        mInputBuffer.pushKey(ke.key, false);
+    }
     return true;
 }
 
@@ -395,6 +692,10 @@ bool GameManager::mouseMoved(const OIS::MouseEvent& me)
         //     context.injectMouseWheelChange(me.state.Z.rel / 120.0f);
         // } 
     }  
+    else
+    {
+        mInputBuffer.pushPitch(me.state.Y.rel);
+    }
     return true;
 }
 
@@ -434,20 +735,26 @@ CEGUI::MouseButton convertButton(OIS::MouseButtonID buttonID)
 bool GameManager::quit(const CEGUI::EventArgs&)
 {
     mShutDown = true;
+    return true;
 }
 
 //---------------------------------------------------------------------------
 bool GameManager::start(const CEGUI::EventArgs&)
 {
+    if (!mSound->isLoaded())
+    {
+        return true;
+    }
+
     mState = PLAY;
 
-    mSound = new Sound();
-    mSound->initSound();
+    mSound->playMusic();
 
     initScene();
 
     CEGUI::System::getSingleton().getDefaultGUIContext().setRootWindow(sheets.at(2));
     CEGUI::System::getSingleton().getDefaultGUIContext().getMouseCursor().hide();
+    return true;
 }
 
 //---------------------------------------------------------------------------
@@ -463,21 +770,39 @@ bool GameManager::frameRenderingQueued(const Ogre::FrameEvent& fe)
         return false;
     }
 
-    // Capture/Update each input device
-    mKeyboard->capture();
-    mMouse->capture();
+    // The scene is queued and the GPU is busy with it, so input that came in
+    // meanwhile is simulated now rather than at the start of the next frame
+    if (mState == PLAY)
+    {
+        captureInput();
+        sampleInput();
+
+        // Inline steps are profiled through the snapshot like threaded ones
+        if (!mPhysicsThread->isThreaded())
+        {
+            mPhysicsThread->update(fe.timeSinceLastFrame);
+        }
+    }
+
+    mSound->update();
 
     if (mState == PLAY)
     {
+        ScopedTimer timer(mProfiler, PROFILE_GUI);
+
+        const float spawnInterval = mLevel.getHeader().spawnInterval;
+
         mTimeSinceLastCat += fe.timeSinceLastFrame;
-        if (mTimeSinceLastCat > 1.0)
+        if (spawnInterval > 0 && mTimeSinceLastCat > spawnInterval)
         {
             spawnCat();
             ++mScore;
             mPlayButtons.at(0)->setText("Score: " + Ogre::StringConverter::toString(mScore));
 
-            mTimeSinceLastCat -= 1.0;
+            mTimeSinceLastCat -= spawnInterval;
         }
+
+        updateProfilerHud();
     }
 
     return true;
@@ -486,162 +811,178 @@ bool GameManager::frameRenderingQueued(const Ogre::FrameEvent& fe)
 //---------------------------------------------------------------------------
 bool GameManager::frameStarted(const Ogre::FrameEvent& fe)
 {
+    mProfiler.nextFrame(fe.timeSinceLastFrame * 1000.0);
+    mFrameLatency.frameStarted(InputBuffer::now());
+
+    std::chrono::high_resolution_clock::time_point workStart =
+        std::chrono::high_resolution_clock::now();
+
+    // Input is sampled right before the scene is built from the latest steps
+    captureInput();
+
     if (mState == MAIN_MENU) 
     {
         CEGUI::System::getSingleton().getDefaultGUIContext().setRootWindow(sheets.at(0));
+
+        if (startButtons.at(0)->isDisabled() && mSound->isLoaded())
+        {
+            startButtons.at(0)->setText("Start");
+            startButtons.at(0)->setEnabled(true);
+        }
         return true;
     }
-    else
+
+    sampleInput();
+
+    bool alive;
     {
-        mTimeSinceLastPhysicsStep += fe.timeSinceLastFrame;
-        if (mTimeSinceLastPhysicsStep > 1.0 / 60.0)
+        ScopedTimer timer(mProfiler, PROFILE_SYNC);
+        alive = applySnapshot(fe.timeSinceLastFrame);
+    }
+
+    double work = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - workStart).count();
+    mAverageRenderWork += (work - mAverageRenderWork) * 0.05;
+    mAverageFrameTime += (fe.timeSinceLastFrame * 1000.0 - mAverageFrameTime) * 0.05;
+
+    return alive;
+}
+
+//---------------------------------------------------------------------------
+void GameManager::captureInput()
+{
+    ScopedTimer timer(mProfiler, PROFILE_INPUT);
+
+    // Capture/Update each input device
+    mKeyboard->capture();
+    mMouse->capture();
+}
+
+//---------------------------------------------------------------------------
+void GameManager::sampleInput()
+{
+    ScopedTimer timer(mProfiler, PROFILE_PLAYER);
+
+    mFrameCommands.clear();
+    mPlayer->applyInput(mInputBuffer, mFrameCommands);
+
+    for (size_t i = 0; i < mFrameCommands.size(); ++i)
+    {
+        mPhysicsThread->pushCommand(mFrameCommands[i]);
+    }
+
+    if (!mFrameCommands.empty())
+    {
+        mLastCommand = mFrameCommands.back();
+    }
+}
+
+//---------------------------------------------------------------------------
+static void applyBodyPose(const BodySnapshot& body, const float alpha)
+{
+    btQuaternion rot = body.previous.getRotation().slerp(body.current.getRotation(), alpha);
+    btVector3 pos = body.previous.getOrigin().lerp(body.current.getOrigin(), alpha);
+
+    body.state->applyPose(Ogre::Vector3(pos.x(), pos.y(), pos.z()),
+        Ogre::Quaternion(rot.w(), rot.x(), rot.y(), rot.z()));
+}
+
+//---------------------------------------------------------------------------
+bool GameManager::applySnapshot(const float frameTime)
+{
+    bool fresh = mPhysicsThread->consumeSnapshot();
+    const PhysicsSnapshot& snapshot = mPhysicsThread->getSnapshot();
+
+    if (fresh)
+    {
+        mProfiler.record(PROFILE_PHYSICS, snapshot.physicsTime);
+        mProfiler.record(PROFILE_HIT_SCAN, snapshot.hitScanTime);
+
+        // Only steps that applied sampled input have a latency to show
+        if (snapshot.inputTime != 0.0)
         {
-            mTimeSinceLastPhysicsStep -= 1.0 / 60.0;
+            mProfiler.record(PROFILE_INPUT_LATENCY, snapshot.inputLatency);
+
+            // Presented at the end of this frame
+            mFrameLatency.shown(snapshot.inputTime);
         }
-        else
+
+        // Bodies that stopped moving end on their latest pose
+        for (size_t i = 0; i < mInterpolatedBodies.size(); ++i)
         {
-            return true;
+            applyBodyPose(mInterpolatedBodies[i], 1.0f);
         }
 
-        if (mPlayer != NULL)
+        for (size_t i = 0; i < snapshot.catEvents.size(); ++i)
         {
-            mPlayer->update (fe.timeSinceLastFrame, mKeyboard, mMouse);
-
-            if (mExCamera)
+            if (snapshot.catEvents[i].launched)
             {
-                mExCamera->update (fe.timeSinceLastFrame,
-                mPlayer->getCameraNode ()->_getDerivedPosition(),
-                mPlayer->getSightNode ()->_getDerivedPosition());
+                snapshot.catEvents[i].cat->attachNode();
+                mCatVisibility->show(snapshot.catEvents[i].cat);
+            }
+            else
+            {
+                snapshot.catEvents[i].cat->detachNode();
+                mCatVisibility->hide(snapshot.catEvents[i].cat);
             }
         }
 
-        if (mPhysicsEngine != nullptr)
-        {
-            mPhysicsEngine->getDynamicsWorld()->stepSimulation(1.0f / 60.0f);
+        mInterpolatedBodies.assign(snapshot.bodies.begin(), snapshot.bodies.end());
+    }
 
-            if (mPlayer != nullptr)
-            {
-                mPlayer->updateAction(mPhysicsEngine->getDynamicsWorld(), fe.timeSinceLastFrame);
-                btTransform& trans = mPlayer->getWorldTransform();
-
-                // Update player rendering position
-                mPlayer->setOgrePosition(Ogre::Vector3(trans.getOrigin().getX(),
-                trans.getOrigin().getY() - mPlayer->getCollisionObjectHalfHeight(),
-                trans.getOrigin().getZ()));
-
-                mPlayer->setOgreOrientation(Ogre::Quaternion(trans.getRotation().getW(),
-                trans.getRotation().getX(),
-                trans.getRotation().getY(),
-                trans.getRotation().getZ()));
-            }
+    float alpha = mPhysicsThread->getAlpha();
 
-            for (int i = 0; i < mPhysicsEngine->getCollisionObjectCount(); i++)
-            {
-                // Get object from collision array and cast to rigidbody
-                btCollisionObject* obj = mPhysicsEngine->getDynamicsWorld()->getCollisionObjectArray()[i];
-                btRigidBody* body = btRigidBody::upcast(obj);
-
-                // Check collisions that are not with the player?
-                if (body && body->getMotionState() && obj->getCollisionFlags() != btCollisionObject::CF_CHARACTER_OBJECT)
-                {
-                    btTransform trans;
-                    body->getMotionState()->getWorldTransform(trans);
-                    void *userPointer = body->getUserPointer();
-
-                    // Play cat sound on collision
-                    mSound->playSound("meow");
-
-                    // Convert rigidbody to OGRE scenenode and update position and orientation
-                    if (userPointer)
-                    {
-                        btQuaternion orientation = trans.getRotation();
-                        Ogre::SceneNode *sceneNode = static_cast<Ogre::SceneNode *>(userPointer);
-
-                        sceneNode->setPosition(Ogre::Vector3(trans.getOrigin().getX(),
-                            trans.getOrigin().getY(),
-                            trans.getOrigin().getZ()));
-
-                        sceneNode->setOrientation(Ogre::Quaternion(orientation.getW(),
-                            orientation.getX(),
-                            orientation.getY(),
-                            orientation.getZ()));
-                    }
-                }
-            }
+    // Only bodies that moved during the last steps are interpolated
+    for (size_t i = 0; i < mInterpolatedBodies.size(); ++i)
+    {
+        applyBodyPose(mInterpolatedBodies[i], alpha);
+    }
+    mSyncedNodeCount = mInterpolatedBodies.size();
 
-            // Check to see if the player was hit by a ball
-            if (mPlayer != nullptr)
-            {
-                btManifoldArray manifoldArray;
-                btPairCachingGhostObject* ghostObject = mPlayer->getGhostObject();
-                btBroadphasePairArray& pairArray =
-                ghostObject->getOverlappingPairCache()->getOverlappingPairArray();
-
-                int numPairs = pairArray.size();
-
-                for (int i = 0; i < numPairs; ++i)
-                {
-                    manifoldArray.clear();
-
-                    const btBroadphasePair& pair = pairArray[i];
-
-                    btBroadphasePair* collisionPair =
-                    mPhysicsEngine->getDynamicsWorld()->getPairCache()->findPair(
-                    pair.m_pProxy0,pair.m_pProxy1);
-
-                    if (!collisionPair) 
-                    {
-                        continue;
-                    }
-
-                    if (collisionPair->m_algorithm)
-                    {
-                        collisionPair->m_algorithm->getAllContactManifolds(manifoldArray);
-                    }
-
-                    for (int j=0;j<manifoldArray.size();j++)
-                    {
-                        btPersistentManifold* manifold = manifoldArray[j];
-
-                        bool isFirstBody = manifold->getBody0() == ghostObject;
-
-                        btScalar direction = isFirstBody ? btScalar(-1.0) : btScalar(1.0);
-
-                        for (int p = 0; p < manifold->getNumContacts(); ++p)
-                        {
-                            const btManifoldPoint& pt = manifold->getContactPoint(p);
-
-                            if (pt.getDistance() < 0.f)
-                            {
-                                const btVector3& ptA = pt.getPositionWorldOnA();
-                                const btVector3& ptB = pt.getPositionWorldOnB();
-                                const btVector3& normalOnB = pt.m_normalWorldOnB;
-
-                                // Exclude collisions with walls
-                                if (std::abs(ptA.x()) >= WALL_COLLIDE_ERROR || std::abs(ptB.x()) >= WALL_COLLIDE_ERROR)
-                                {
-                                    continue;
-                                }
-
-                                if (std::abs(ptA.z()) >= WALL_COLLIDE_ERROR || std::abs(ptB.z()) >= WALL_COLLIDE_ERROR)
-                                {
-                                    continue;
-                                }
-
-                                if (std::abs(ptA.y()) <= 0.0 || std::abs(ptB.y()) <= 0.0)
-                                {    
-                                    continue;
-                                }
-
-                                return false;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-   }
-    return true;
+    mCatVisibility->update(mCamera->getDerivedPosition());
+
+    // Update player rendering position
+    btVector3 origin = snapshot.playerPrevious.getOrigin().lerp(snapshot.playerCurrent.getOrigin(), alpha);
+    btQuaternion rotation = snapshot.playerPrevious.getRotation().slerp(snapshot.playerCurrent.getRotation(), alpha);
+
+    mPlayer->setOgrePosition(Ogre::Vector3(origin.getX(),
+        origin.getY() - mPlayer->getCollisionObjectHalfHeight(),
+        origin.getZ()));
+
+    mPlayer->setOgreOrientation(Ogre::Quaternion(rotation.getW(),
+        rotation.getX(),
+        rotation.getY(),
+        rotation.getZ()));
+
+    // Per frame the camera follows the interpolated player; per step it
+    // catches up on the time since the last fresh snapshot
+    mCameraElapsed += frameTime;
+    if (mExCamera && (fresh || mGraphicsConfig.cameraEveryFrame))
+    {
+        btVector3 velocity = (snapshot.playerCurrent.getOrigin()
+            - snapshot.playerPrevious.getOrigin()) / btScalar(PHYSICS_STEP);
+
+        mExCamera->update (mCameraElapsed,
+        mPlayer->getCameraNode ()->_getDerivedPosition(),
+        mPlayer->getSightNode ()->_getDerivedPosition(),
+        Ogre::Vector3(velocity.x(), velocity.y(), velocity.z()));
+        mCameraElapsed = 0;
+    }
+
+    if (mExCamera && fresh)
+    {
+        mSpatialAudio->setListener(mExCamera->getCameraPosition(), mExCamera->getCameraRight());
+        mSpatialAudio->update();
+        mSpatialAudio->play(snapshot.sounds);
+    }
+
+    if (snapshot.replayFinished)
+    {
+        Ogre::LogManager::getSingletonPtr()->logMessage("*** Replay of " + mReplayFile + " finished ***");
+        return false;
+    }
+
+    return !snapshot.playerHit;
 }
 
 //---------------------------------------------------------------------------
@@ -661,8 +1002,94 @@ extern "C"
   int main(int argc, char *argv[])
 #endif
   {
+#if OGRE_PLATFORM != OGRE_PLATFORM_WIN32
+    bool threaded = true;
+    bool staticWalls = true;
+    bool instancedCats = true;
+    bool headless = false;
+    std::string profileDump;
+    std::string recordFile;
+    std::string replayFile;
+    std::string loadStateFile;
+    std::string saveStateFile;
+    unsigned long steps = HEADLESS_STEPS;
+    int spawnInterval = HEADLESS_SPAWN_INTERVAL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string arg(argv[i]);
+      if (arg == "--single-thread")
+      {
+        threaded = false;
+      }
+      else if (arg == "--unbatched-walls")
+      {
+        staticWalls = false;
+      }
+      else if (arg == "--no-instancing")
+      {
+        instancedCats = false;
+      }
+      else if (arg == "--headless")
+      {
+        headless = true;
+      }
+      else if (arg == "--steps" && i + 1 < argc)
+      {
+        steps = std::strtoul(argv[++i], 0, 10);
+      }
+      else if (arg == "--spawn-every" && i + 1 < argc)
+      {
+        spawnInterval = std::atoi(argv[++i]);
+      }
+      else if (arg == "--profile-dump" && i + 1 < argc)
+      {
+        profileDump = argv[++i];
+      }
+      else if (arg == "--record" && i + 1 < argc)
+      {
+        recordFile = argv[++i];
+      }
+      else if (arg == "--replay" && i + 1 < argc)
+      {
+        replayFile = argv[++i];
+      }
+      else if (arg == "--load-state" && i + 1 < argc)
+      {
+        loadStateFile = argv[++i];
+      }
+      else if (arg == "--save-state" && i + 1 < argc)
+      {
+        saveStateFile = argv[++i];
+      }
+    }
+
+    // No window, config dialog, GUI or input devices
+    if (headless)
+    {
+      HeadlessRunner runner(steps, spawnInterval);
+      runner.setStateFiles(loadStateFile, saveStateFile);
+      if (!replayFile.empty() && !runner.setReplay(replayFile))
+      {
+        std::cerr << "Could not read input recording " << replayFile << std::endl;
+        return 1;
+      }
+      return runner.run();
+    }
+#endif
+
     GameManager app;
 
+#if OGRE_PLATFORM != OGRE_PLATFORM_WIN32
+    app.setPhysicsThreaded(threaded);
+    app.setStaticWalls(staticWalls);
+    app.setInstancedCats(instancedCats);
+    app.setProfileDump(profileDump);
+    app.setRecordFile(recordFile);
+    app.setReplayFile(replayFile);
+    app.setStateFile(loadStateFile);
+#endif
+
     try
     {
       app.go();
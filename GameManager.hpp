@@ -1,12 +1,28 @@
 #ifndef GameManager_hpp
 #define GameManager_hpp
 
+#include "Arena.hpp"
+#include "AssetCache.hpp"
 #include "BulletPhysics.hpp"
 #include "Cat.hpp"
+#include "CatDespawner.hpp"
+#include "CatPool.hpp"
+#include "CatVisibility.hpp"
+#include "ContactSounds.hpp"
 #include "ExtendedCamera.hpp"
+#include "FrameLatency.hpp"
+#include "GraphicsConfig.hpp"
+#include "InputBuffer.hpp"
+#include "InputRecording.hpp"
+#include "Level.hpp"
+#include "OgreMotionState.hpp"
+#include "PhysicsThread.hpp"
 #include "Player.hpp"
+#include "PlayerCommand.hpp"
+#include "Profiler.hpp"
+#include "Simulation.hpp"
 #include "Sound.hpp"
-#include "Wall.hpp"
+#include "SpatialAudio.hpp"
 
 #include <OgreRoot.h>
 #include <OgreWindowEventUtilities.h>
@@ -30,12 +46,11 @@
 #include <string>
 #include <iostream>
 #include <cmath>
+#include <chrono>
 
 #include <CEGUI/CEGUI.h>
 #include <CEGUI/RendererModules/Ogre/Renderer.h>
 
-#define WALL_COLLIDE_ERROR 745
-
 enum GameState {MAIN_MENU = 0, PLAY = 1};
 
 CEGUI::MouseButton convertButton(OIS::MouseButtonID buttonID);
@@ -52,8 +67,31 @@ public:
 
     bool go();
 
+    // Run Bullet on its own thread (default) or inline in frameStarted
+    void setPhysicsThreaded(const bool threaded);
+
+    // Write the frame profile to fileName on exit
+    void setProfileDump(const std::string& fileName);
+
+    // Save the per-step input and seed of the session to fileName on exit
+    void setRecordFile(const std::string& fileName);
+
+    // Drive the session from a recording instead of the devices; the game
+    // quits when it runs out
+    void setReplayFile(const std::string& fileName);
+
+    // Start play from a saved world state instead of an empty arena
+    void setStateFile(const std::string& fileName);
+
+    // Bake the arena into one static batch (default) or keep a node per wall
+    void setStaticWalls(const bool batched);
+
+    // Draw cats with hardware instancing (default) or an entity each
+    void setInstancedCats(const bool instanced);
+
 private:
     bool initOgre();
+    void loadAssets();
     void initBullet();
     void initInput();
     void initScene();
@@ -65,7 +103,14 @@ private:
     bool initOgreWindow();
     void initOgreViewports();
 
+    void captureInput();
+    // Turns the buffered input into commands for the physics thread
+    void sampleInput();
     void spawnCat();
+    bool applySnapshot(const float frameTime);
+    void logPhysicsStats();
+    void logCatPoolStats();
+    void updateProfilerHud();
 
     void windowResized(Ogre::RenderWindow* rw);
     void windowClosed(Ogre::RenderWindow* rw);
@@ -89,21 +134,65 @@ private:
     Ogre::Camera* mCamera;
     ExtendedCamera* mExCamera;
     Player* mPlayer;
+    CatPool* mCatPool;
+    CatDespawner* mCatDespawner;
+    CatVisibility* mCatVisibility;
 
     BulletPhysics* mPhysicsEngine;
+    Simulation* mSimulation;
+    ContactSounds* mContactSounds;
+    PhysicsThread* mPhysicsThread;
+    bool mPhysicsThreaded;
+    int mMaxSubSteps;
+    bool mStaticWalls;
+    bool mInstancedCats;
+    GraphicsConfig mGraphicsConfig;
+    Level mLevel;
+    AssetCache mAssets;
 
     OIS::InputManager* mInputMgr;
     OIS::Keyboard* mKeyboard;
     OIS::Mouse* mMouse;
 
     Sound* mSound;
+    SpatialAudio* mSpatialAudio;
 
     bool mShutDown;
     int mScore;
 
-    double mTimeSinceLastPhysicsStep;
     double mTimeSinceLastCat;
 
+    // Key and mouse events from the OIS callbacks, drained once per frame
+    InputBuffer mInputBuffer;
+    std::vector<PlayerCommand> mFrameCommands;
+    FrameLatency mFrameLatency;
+
+    // Latest input, repeated when a cat spawn is requested
+    PlayerCommand mLastCommand;
+
+    // Bodies that moved in the last physics snapshot
+    std::vector<BodySnapshot> mInterpolatedBodies;
+
+    // Scene nodes pushed from Bullet motion states in the last frame
+    size_t mSyncedNodeCount;
+    float mCameraElapsed; // Seconds since the camera last followed
+
+    // Render thread timing, milliseconds
+    double mAverageFrameTime;
+    double mAverageRenderWork;
+
+    // Per-section frame timing, shown with F3 and dumped with F4
+    Profiler mProfiler;
+    bool mShowProfiler;
+    int mProfilerHudCountdown;
+    std::string mProfileDumpFile;
+
+    // Record or replay of the per-step input
+    InputRecording mRecording;
+    std::string mRecordFile;
+    std::string mReplayFile;
+    std::string mStateFile;
+
     GameState mState;
     CEGUI::OgreRenderer* mRenderer;
     std::vector<CEGUI::Window*> sheets;
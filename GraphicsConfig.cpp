@@ -0,0 +1,177 @@
+#include "GraphicsConfig.hpp"
+
+#include <OgreDistanceLodStrategy.h>
+#include <OgreLodConfig.h>
+#include <OgreProgressiveMeshGenerator.h>
+#include <OgreShadowCameraSetupFocused.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+//---------------------------------------------------------------------------
+GraphicsConfig::GraphicsConfig()
+    : shadows(SHADOWS_TEXTURE),
+    shadowTextureSize(1024),
+    shadowTextureCount(1),
+    shadowFarDistance(3000.0f),
+    catDrawDistance(4000.0f),
+    cameraSmoothTime(0.2f),
+    cameraLookahead(0.1f),
+    cameraEveryFrame(true)
+{
+    LodStep near = { 1500.0f, 0.5f };
+    LodStep far = { 3000.0f, 0.8f };
+    lodSteps.push_back(near);
+    lodSteps.push_back(far);
+}
+
+//---------------------------------------------------------------------------
+// distance:reduction pairs separated by commas, e.g. 1500:0.5,3000:0.8
+static std::vector<LodStep> parseLodSteps(const std::string& list)
+{
+    std::vector<LodStep> steps;
+    std::istringstream in(list);
+    std::string item;
+
+    while (std::getline(in, item, ','))
+    {
+        size_t split = item.find(':');
+        if (split == std::string::npos)
+        {
+            continue;
+        }
+
+        LodStep step = { float(std::atof(item.substr(0, split).c_str())),
+            float(std::atof(item.substr(split + 1).c_str())) };
+        if (step.distance > 0 && step.reduction > 0 && step.reduction < 1)
+        {
+            steps.push_back(step);
+        }
+    }
+
+    return steps;
+}
+
+//---------------------------------------------------------------------------
+bool GraphicsConfig::load(const std::string& fileName)
+{
+    std::ifstream file(fileName.c_str());
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+
+        size_t split = line.find('=');
+        if (split == std::string::npos)
+        {
+            continue;
+        }
+
+        std::string key, value;
+        std::istringstream(line.substr(0, split)) >> key;
+        std::istringstream(line.substr(split + 1)) >> value;
+
+        if (key == "Shadows")
+        {
+            if (value == "none" || value == "off")
+            {
+                this->shadows = SHADOWS_NONE;
+            }
+            else if (value == "stencil")
+            {
+                this->shadows = SHADOWS_STENCIL;
+            }
+            else
+            {
+                this->shadows = SHADOWS_TEXTURE;
+            }
+        }
+        else if (key == "ShadowTextureSize")
+        {
+            this->shadowTextureSize = (unsigned short)std::atoi(value.c_str());
+        }
+        else if (key == "ShadowTextureCount")
+        {
+            this->shadowTextureCount = std::atoi(value.c_str());
+        }
+        else if (key == "ShadowFarDistance")
+        {
+            this->shadowFarDistance = std::atof(value.c_str());
+        }
+        else if (key == "LodLevels")
+        {
+            this->lodSteps = parseLodSteps(value);
+        }
+        else if (key == "CatDrawDistance")
+        {
+            this->catDrawDistance = std::atof(value.c_str());
+        }
+        else if (key == "CameraSmoothTime")
+        {
+            this->cameraSmoothTime = std::atof(value.c_str());
+        }
+        else if (key == "CameraLookahead")
+        {
+            this->cameraLookahead = std::atof(value.c_str());
+        }
+        else if (key == "CameraUpdate")
+        {
+            this->cameraEveryFrame = (value != "step");
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void GraphicsConfig::applyShadows(Ogre::SceneManager* sceneMgr) const
+{
+    switch (shadows)
+    {
+    case SHADOWS_NONE:
+        sceneMgr->setShadowTechnique(Ogre::SHADOWTYPE_NONE);
+        break;
+
+    case SHADOWS_STENCIL:
+        sceneMgr->setShadowTechnique(Ogre::SHADOWTYPE_STENCIL_ADDITIVE);
+        sceneMgr->setShadowFarDistance(shadowFarDistance);
+        break;
+
+    case SHADOWS_TEXTURE:
+        sceneMgr->setShadowTechnique(Ogre::SHADOWTYPE_TEXTURE_MODULATIVE);
+        sceneMgr->setShadowTextureSize(shadowTextureSize);
+        sceneMgr->setShadowTextureCount(shadowTextureCount);
+        sceneMgr->setShadowFarDistance(shadowFarDistance);
+        sceneMgr->setShadowColour(Ogre::ColourValue(0.5, 0.5, 0.5));
+
+        // Fits the shadow map to what the camera sees of the directional light
+        sceneMgr->setShadowCameraSetup(
+            Ogre::ShadowCameraSetupPtr(new Ogre::FocusedShadowCameraSetup()));
+        break;
+    }
+}
+
+//---------------------------------------------------------------------------
+void GraphicsConfig::applyLod(const Ogre::MeshPtr& mesh) const
+{
+    if (mesh.isNull() || lodSteps.empty())
+    {
+        return;
+    }
+
+    Ogre::MeshPtr target = mesh;
+    Ogre::LodConfig lod(target, Ogre::DistanceLodStrategy::getSingletonPtr());
+    for (size_t i = 0; i < lodSteps.size(); ++i)
+    {
+        lod.createGeneratedLodLevel(lodSteps[i].distance, lodSteps[i].reduction);
+    }
+
+    Ogre::ProgressiveMeshGenerator generator;
+    generator.generateLodLevels(lod);
+}
@@ -0,0 +1,54 @@
+#ifndef GraphicsConfig_hpp
+#define GraphicsConfig_hpp
+
+#include <OgreMeshManager.h>
+#include <OgreSceneManager.h>
+
+#include <string>
+#include <vector>
+
+#define GRAPHICS_CONFIG_FILE "graphics.cfg"
+
+enum ShadowMode
+{
+    SHADOWS_NONE,
+    SHADOWS_TEXTURE, // One modulative shadow map per light, no extra light passes
+    SHADOWS_STENCIL // Additive stencil volumes, the sharpest and the most expensive
+};
+
+// One generated level of detail: from distance on, the mesh keeps
+// 1 - reduction of its vertices
+struct LodStep
+{
+    float distance;
+    float reduction;
+};
+
+// Render settings that trade looks for frame time, read from
+// GRAPHICS_CONFIG_FILE. Anything missing keeps its default.
+struct GraphicsConfig
+{
+    GraphicsConfig();
+
+    bool load(const std::string& fileName);
+
+    // Sets the scene manager's shadow technique and its texture settings
+    void applyShadows(Ogre::SceneManager* sceneMgr) const;
+    // Generates lodSteps for a loaded mesh. Must run before any entity is
+    // made from the mesh.
+    void applyLod(const Ogre::MeshPtr& mesh) const;
+
+    ShadowMode shadows;
+    unsigned short shadowTextureSize; // Pixels per side of each shadow map
+    size_t shadowTextureCount; // Lights that can cast texture shadows at once
+    float shadowFarDistance; // Casters further from the camera are skipped
+
+    std::vector<LodStep> lodSteps; // Nearest first
+    float catDrawDistance; // Cats further from the camera are hidden, 0 never
+
+    float cameraSmoothTime; // Seconds for the follow camera to settle
+    float cameraLookahead; // Seconds of player velocity the camera looks ahead
+    bool cameraEveryFrame; // Follow every frame, not only on fresh physics steps
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "HeadlessRunner.hpp"
+#include "Arena.hpp"
+#include "FixedTimestep.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+//---------------------------------------------------------------------------
+HeadlessRunner::HeadlessRunner(const unsigned long steps, const int spawnInterval)
+    : mPhysicsEngine(0),
+    mPlayer(0),
+    mCatPool(0),
+    mCatDespawner(0),
+    mSimulation(0),
+    mSteps(steps),
+    mSpawnInterval(spawnInterval),
+    mReplaying(false)
+{
+}
+
+//---------------------------------------------------------------------------
+HeadlessRunner::~HeadlessRunner()
+{
+    delete mSimulation;
+    delete mCatDespawner;
+    delete mCatPool;
+    delete mPlayer;
+    delete mPhysicsEngine;
+}
+
+//---------------------------------------------------------------------------
+bool HeadlessRunner::setReplay(const std::string& fileName)
+{
+    if (!mReplay.load(fileName))
+    {
+        return false;
+    }
+
+    mReplaying = true;
+    mSteps = mReplay.getStepCount();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void HeadlessRunner::setStateFiles(const std::string& loadFile, const std::string& saveFile)
+{
+    mLoadStateFile = loadFile;
+    mSaveStateFile = saveFile;
+}
+
+//---------------------------------------------------------------------------
+int HeadlessRunner::run()
+{
+    PhysicsConfig config;
+    config.load(PHYSICS_CONFIG_FILE);
+
+    Level level;
+    if (!level.load())
+    {
+        std::cerr << "Could not load level " << LEVEL_FILE << std::endl;
+        return 1;
+    }
+
+    mPhysicsEngine = new BulletPhysics();
+    mPhysicsEngine->initObjects(config);
+    mPhysicsEngine->getDynamicsWorld()->setGravity(PHYSICS_GRAVITY);
+
+    // No scene manager and no sound: physics bodies only
+    mPlayer = new Player("Player 1", 0, mPhysicsEngine, 0);
+    mCatPool = new CatPool(mPhysicsEngine, 0, mPlayer, "Cat.mesh");
+    CatLifetimePolicy policy;
+    policy.playMin = level.getPlayMin();
+    policy.playMax = level.getPlayMax();
+    mCatDespawner = new CatDespawner(mCatPool, policy);
+    mSimulation = new Simulation(mPhysicsEngine, mPlayer, mCatPool, mCatDespawner, 0);
+
+    Arena arena(mPhysicsEngine, 0, level);
+    arena.build();
+
+    mCatPool->prewarm();
+
+    std::vector<CatEvent> events;
+
+    if (!mLoadStateFile.empty())
+    {
+        std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+        if (!mPhysicsEngine->loadState(mLoadStateFile))
+        {
+            std::cerr << "Could not load world state " << mLoadStateFile << std::endl;
+            return 1;
+        }
+        mCatPool->syncWithWorld();
+        mCatPool->takeEvents(events);
+        events.clear();
+
+        std::cout << "Headless: loaded " << mPhysicsEngine->getStateObjectCount()
+                  << " bodies from " << mLoadStateFile << " in "
+                  << std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - loadStart).count()
+                  << " ms" << std::endl;
+    }
+
+    unsigned long hitSteps = 0;
+    double totalStepTime = 0.0;
+    double maxStepTime = 0.0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (unsigned long i = 0; i < mSteps; ++i)
+    {
+        // The player is not reset when hit, the run keeps loading the world
+        PlayerCommand cmd;
+        if (!mReplaying || !mReplay.next(cmd))
+        {
+            cmd = scriptedCommand(i);
+        }
+
+        if (!mSimulation->step(cmd, PHYSICS_STEP))
+        {
+            ++hitSteps;
+        }
+
+        totalStepTime += mSimulation->getLastStepTime();
+        maxStepTime = std::max(maxStepTime, mSimulation->getLastStepTime());
+
+        // Nobody shows or hides nodes here
+        mCatPool->takeEvents(events);
+        events.clear();
+    }
+
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    double stepsPerSecond = seconds > 0.0 ? mSteps / seconds : 0.0;
+
+    std::cout << "Headless: " << mSteps << " steps in " << seconds << " s, "
+              << stepsPerSecond << " steps/s ("
+              << stepsPerSecond * PHYSICS_STEP << "x real time)" << std::endl;
+    std::cout << "  world: " << (mPhysicsEngine->isMultithreaded() ? "multithreaded, " : "serial, ")
+              << mPhysicsEngine->getThreadCount() << " threads, "
+              << mPhysicsEngine->getCollisionObjectCount() << " collision objects" << std::endl;
+    std::cout << "  stepSimulation: avg " << (mSteps ? totalStepTime / mSteps : 0.0)
+              << " ms, max " << maxStepTime << " ms" << std::endl;
+    std::cout << "  cats: live " << mCatPool->getLiveCount()
+              << ", high-water " << mCatPool->getHighWater()
+              << ", launched " << mCatPool->getHits() + mCatPool->getMisses() + mCatPool->getRecycled()
+              << ", expired " << mCatDespawner->getExpired()
+              << ", rested " << mCatDespawner->getRested()
+              << ", escaped " << mCatDespawner->getEscaped()
+              << ", evicted " << mCatDespawner->getEvicted() << std::endl;
+    std::cout << "  player hit on " << hitSteps << " steps" << std::endl;
+
+    if (!mSaveStateFile.empty())
+    {
+        std::chrono::steady_clock::time_point saveStart = std::chrono::steady_clock::now();
+        bool saved = mPhysicsEngine->saveState(mSaveStateFile);
+        std::cout << "  world state " << (saved ? "saved to " : "could not be saved to ")
+                  << mSaveStateFile << " in " << std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - saveStart).count()
+                  << " ms" << std::endl;
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+// Walks forward, turns left, backs up and turns right while sweeping the
+// cannon up and down and firing at a steady rate
+PlayerCommand HeadlessRunner::scriptedCommand(const unsigned long step) const
+{
+    PlayerCommand cmd;
+
+    unsigned long phase = step % HEADLESS_SCRIPT_LENGTH;
+    cmd.forward = phase < 120;
+    cmd.turnLeft = phase >= 120 && phase < 180;
+    cmd.backward = phase >= 180 && phase < 300;
+    cmd.turnRight = phase >= 300 && phase < 360;
+
+    cmd.spawnCat = mSpawnInterval > 0 && step % mSpawnInterval == 0;
+
+    // Between -10 and 85 degrees, the range the mouse allows
+    btScalar sweep = std::sin(step * SIMD_2_PI / HEADLESS_SCRIPT_LENGTH);
+    btScalar pitch = btRadians(37.5f + 47.5f * sweep);
+    cmd.cannonPitch = btQuaternion(btVector3(1, 0, 0), pitch);
+
+    return cmd;
+}
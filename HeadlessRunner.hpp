@@ -0,0 +1,57 @@
+#ifndef HeadlessRunner_hpp
+#define HeadlessRunner_hpp
+
+#include "BulletPhysics.hpp"
+#include "CatDespawner.hpp"
+#include "CatPool.hpp"
+#include "InputRecording.hpp"
+#include "Player.hpp"
+#include "PlayerCommand.hpp"
+#include "Simulation.hpp"
+
+#include <string>
+
+#define HEADLESS_STEPS 36000 // Ten minutes of game time
+#define HEADLESS_SPAWN_INTERVAL 30 // Steps between scripted cat launches
+#define HEADLESS_SCRIPT_LENGTH 600 // Steps before the scripted input repeats
+
+// Runs the game simulation without Ogre, CEGUI, OIS or sound. Scripted input
+// drives the player, steps run back to back as fast as the machine allows,
+// and the throughput is printed, so build boxes can use it as a load and
+// regression driver.
+class HeadlessRunner
+{
+public:
+    HeadlessRunner(const unsigned long steps = HEADLESS_STEPS,
+        const int spawnInterval = HEADLESS_SPAWN_INTERVAL);
+    ~HeadlessRunner();
+
+    // Steps through a recorded session instead of the script. False when
+    // the file cannot be read.
+    bool setReplay(const std::string& fileName);
+
+    // The run starts from the world state in loadFile, for a pre-filled
+    // arena, and leaves its final state in saveFile. Either may be empty.
+    void setStateFiles(const std::string& loadFile, const std::string& saveFile);
+
+    // Returns the process exit code
+    int run();
+
+private:
+    PlayerCommand scriptedCommand(const unsigned long step) const;
+
+    BulletPhysics* mPhysicsEngine;
+    Player* mPlayer;
+    CatPool* mCatPool;
+    CatDespawner* mCatDespawner;
+    Simulation* mSimulation;
+
+    unsigned long mSteps;
+    int mSpawnInterval;
+    InputRecording mReplay;
+    bool mReplaying;
+    std::string mLoadStateFile;
+    std::string mSaveStateFile;
+};
+
+#endif
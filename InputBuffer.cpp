@@ -0,0 +1,88 @@
+#include "InputBuffer.hpp"
+
+#include <chrono>
+
+//---------------------------------------------------------------------------
+InputBuffer::InputBuffer()
+    : mDropped(0)
+{
+}
+
+//---------------------------------------------------------------------------
+bool InputBuffer::pushKey(const OIS::KeyCode key, const bool pressed)
+{
+    InputEvent event;
+    event.pressed = pressed;
+    event.delta = 0.0f;
+    event.time = now();
+
+    switch (key)
+    {
+        case OIS::KC_W:
+        case OIS::KC_COMMA:
+        case OIS::KC_UP:
+            event.action = INPUT_FORWARD;
+            break;
+        case OIS::KC_S:
+        case OIS::KC_O:
+        case OIS::KC_DOWN:
+            event.action = INPUT_BACKWARD;
+            break;
+        case OIS::KC_A:
+        case OIS::KC_LEFT:
+            event.action = INPUT_TURN_LEFT;
+            break;
+        case OIS::KC_D:
+        case OIS::KC_E:
+        case OIS::KC_RIGHT:
+            event.action = INPUT_TURN_RIGHT;
+            break;
+        default:
+            return false;
+    }
+
+    return push(event);
+}
+
+//---------------------------------------------------------------------------
+bool InputBuffer::pushPitch(const float delta)
+{
+    InputEvent event;
+    event.action = INPUT_PITCH;
+    event.pressed = false;
+    event.delta = delta;
+    event.time = now();
+
+    return push(event);
+}
+
+//---------------------------------------------------------------------------
+bool InputBuffer::push(const InputEvent& event)
+{
+    if (!mEvents.push(event))
+    {
+        ++mDropped;
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool InputBuffer::pop(InputEvent& event)
+{
+    return mEvents.pop(event);
+}
+
+//---------------------------------------------------------------------------
+unsigned long InputBuffer::getDropped() const
+{
+    return mDropped;
+}
+
+//---------------------------------------------------------------------------
+double InputBuffer::now()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,55 @@
+#ifndef InputBuffer_hpp
+#define InputBuffer_hpp
+
+#include "SpscQueue.hpp"
+
+#include <OISKeyboard.h>
+
+#define INPUT_BUFFER_SIZE 256
+
+// What a key or mouse event does to the player
+enum InputAction
+{
+    INPUT_FORWARD,
+    INPUT_BACKWARD,
+    INPUT_TURN_LEFT,
+    INPUT_TURN_RIGHT,
+    INPUT_PITCH,
+    INPUT_ACTION_COUNT
+};
+
+struct InputEvent
+{
+    InputAction action;
+    bool pressed; // Key went down, for the movement actions
+    float delta; // Relative mouse Y, for INPUT_PITCH
+    double time; // Seconds on the input clock when the event arrived
+};
+
+// Timestamped events from the OIS callbacks, in arrival order. Filled while
+// the devices are captured and drained by the player once per frame, so no
+// key edge or mouse movement is lost between frames.
+class InputBuffer
+{
+public:
+    InputBuffer();
+
+    // False for keys that do not move the player, or when the buffer is full
+    bool pushKey(const OIS::KeyCode key, const bool pressed);
+    bool pushPitch(const float delta);
+
+    bool pop(InputEvent& event);
+
+    unsigned long getDropped() const;
+
+    // Seconds on a steady clock shared by the render and physics threads
+    static double now();
+
+private:
+    bool push(const InputEvent& event);
+
+    SpscQueue<InputEvent, INPUT_BUFFER_SIZE> mEvents;
+    unsigned long mDropped;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "InputRecording.hpp"
+
+#include <fstream>
+
+#define RECORD_FORWARD 0x01
+#define RECORD_BACKWARD 0x02
+#define RECORD_TURN_LEFT 0x04
+#define RECORD_TURN_RIGHT 0x08
+#define RECORD_SPAWN 0x10
+#define RECORD_PITCH 0x20
+
+struct RecordingHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t seed;
+    uint32_t steps;
+};
+
+//---------------------------------------------------------------------------
+InputRecording::InputRecording()
+    : mNext(0),
+    mSeed(0)
+{
+}
+
+//---------------------------------------------------------------------------
+void InputRecording::setSeed(const uint32_t seed)
+{
+    mSeed = seed;
+}
+
+//---------------------------------------------------------------------------
+uint32_t InputRecording::getSeed() const
+{
+    return mSeed;
+}
+
+//---------------------------------------------------------------------------
+void InputRecording::append(const PlayerCommand& cmd)
+{
+    PlayerCommand step = cmd;
+    // Wall clock times differ on every run
+    step.time = 0.0;
+    mCommands.push_back(step);
+}
+
+//---------------------------------------------------------------------------
+bool InputRecording::next(PlayerCommand& cmd)
+{
+    if (mNext >= mCommands.size())
+    {
+        return false;
+    }
+
+    cmd = mCommands[mNext++];
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool InputRecording::isFinished() const
+{
+    return mNext >= mCommands.size();
+}
+
+//---------------------------------------------------------------------------
+size_t InputRecording::getStepCount() const
+{
+    return mCommands.size();
+}
+
+//---------------------------------------------------------------------------
+bool InputRecording::save(const std::string& fileName) const
+{
+    std::ofstream file(fileName.c_str(), std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    RecordingHeader header = { INPUT_RECORDING_MAGIC, INPUT_RECORDING_VERSION, 0, mSeed,
+        uint32_t(mCommands.size()) };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    btQuaternion pitch = btQuaternion::getIdentity();
+
+    for (size_t i = 0; i < mCommands.size(); ++i)
+    {
+        const PlayerCommand& cmd = mCommands[i];
+
+        uint8_t flags = (cmd.forward ? RECORD_FORWARD : 0)
+            | (cmd.backward ? RECORD_BACKWARD : 0)
+            | (cmd.turnLeft ? RECORD_TURN_LEFT : 0)
+            | (cmd.turnRight ? RECORD_TURN_RIGHT : 0)
+            | (cmd.spawnCat ? RECORD_SPAWN : 0)
+            | (cmd.cannonPitch != pitch ? RECORD_PITCH : 0);
+        file.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+
+        // The pitch only changes while the mouse moves
+        if (flags & RECORD_PITCH)
+        {
+            pitch = cmd.cannonPitch;
+            float values[4] = { float(pitch.x()), float(pitch.y()), float(pitch.z()),
+                float(pitch.w()) };
+            file.write(reinterpret_cast<const char*>(values), sizeof(values));
+        }
+    }
+
+    return file.good();
+}
+
+//---------------------------------------------------------------------------
+bool InputRecording::load(const std::string& fileName)
+{
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    RecordingHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || header.magic != INPUT_RECORDING_MAGIC || header.version != INPUT_RECORDING_VERSION)
+    {
+        return false;
+    }
+
+    std::vector<PlayerCommand> commands;
+    commands.reserve(header.steps);
+    btQuaternion pitch = btQuaternion::getIdentity();
+
+    for (uint32_t i = 0; i < header.steps; ++i)
+    {
+        uint8_t flags;
+        if (!file.read(reinterpret_cast<char*>(&flags), sizeof(flags)))
+        {
+            return false;
+        }
+
+        if (flags & RECORD_PITCH)
+        {
+            float values[4];
+            if (!file.read(reinterpret_cast<char*>(values), sizeof(values)))
+            {
+                return false;
+            }
+            pitch = btQuaternion(values[0], values[1], values[2], values[3]);
+        }
+
+        PlayerCommand cmd;
+        cmd.forward = (flags & RECORD_FORWARD) != 0;
+        cmd.backward = (flags & RECORD_BACKWARD) != 0;
+        cmd.turnLeft = (flags & RECORD_TURN_LEFT) != 0;
+        cmd.turnRight = (flags & RECORD_TURN_RIGHT) != 0;
+        cmd.spawnCat = (flags & RECORD_SPAWN) != 0;
+        cmd.cannonPitch = pitch;
+        commands.push_back(cmd);
+    }
+
+    mCommands.swap(commands);
+    mNext = 0;
+    mSeed = header.seed;
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef InputRecording_hpp
+#define InputRecording_hpp
+
+#include "PlayerCommand.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define INPUT_RECORDING_MAGIC 0x52494344 // "DCIR" in a little-endian file
+#define INPUT_RECORDING_VERSION 1
+
+// The command every physics step ran with, and the rand seed of the
+// session. The simulation draws no random numbers: replaying the commands
+// step for step through the serial world, at the fixed step, gives the
+// same cat launches and contacts, so a session can be timed again on each
+// build. Multithreaded Bullet worlds do not solve in a fixed order and may
+// drift. The seed only makes Sound pick the same samples again.
+//
+// File layout, native byte order:
+//   uint32 magic, uint16 version, uint16 reserved, uint32 seed, uint32 steps
+//   per step: uint8 flags, then four floats (x, y, z, w) of the cannon
+//   pitch when RECORD_PITCH is set; otherwise the pitch is unchanged
+class InputRecording
+{
+public:
+    InputRecording();
+
+    void setSeed(const uint32_t seed);
+    uint32_t getSeed() const;
+
+    // Recording, physics thread
+    void append(const PlayerCommand& cmd);
+
+    // Replay, physics thread. False once every step was handed out.
+    bool next(PlayerCommand& cmd);
+    bool isFinished() const;
+
+    size_t getStepCount() const;
+
+    bool save(const std::string& fileName) const;
+    bool load(const std::string& fileName);
+
+private:
+    std::vector<PlayerCommand> mCommands;
+    size_t mNext;
+    uint32_t mSeed;
+};
+
+#endif
@@ -0,0 +1,395 @@
+#include "Level.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//---------------------------------------------------------------------------
+Level::Level()
+    : mData(0),
+    mSize(0),
+    mMapped(false)
+{
+}
+
+//---------------------------------------------------------------------------
+Level::~Level()
+{
+    unload();
+}
+
+//---------------------------------------------------------------------------
+bool Level::load(const std::string& textFile, const std::string& binaryFile)
+{
+    unload();
+
+    struct stat text, binary;
+    bool hasText = stat(textFile.c_str(), &text) == 0;
+    bool hasBinary = stat(binaryFile.c_str(), &binary) == 0;
+
+    if (hasText && (!hasBinary || text.st_mtime > binary.st_mtime))
+    {
+        std::vector<char> compiled;
+        if (!compile(textFile, compiled))
+        {
+            std::cerr << "Level: " << textFile << " is not a valid level" << std::endl;
+            return false;
+        }
+
+        std::ofstream file(binaryFile.c_str(), std::ios::binary);
+        file.write(&compiled[0], compiled.size());
+        file.close();
+
+        // Still playable from memory where the binary cannot be written
+        if (file.fail())
+        {
+            mBuffer.swap(compiled);
+            mData = &mBuffer[0];
+            mSize = mBuffer.size();
+            return validate();
+        }
+    }
+
+    return map(binaryFile) && validate();
+}
+
+//---------------------------------------------------------------------------
+bool Level::map(const std::string& binaryFile)
+{
+#ifndef _WIN32
+    int fd = open(binaryFile.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    mData = static_cast<const char*>(data);
+    mSize = info.st_size;
+    mMapped = true;
+    return true;
+#else
+    std::ifstream file(binaryFile.c_str(), std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return false;
+    }
+
+    mBuffer.resize(size_t(file.tellg()));
+    file.seekg(0);
+    if (mBuffer.empty() || !file.read(&mBuffer[0], mBuffer.size()))
+    {
+        return false;
+    }
+
+    mData = &mBuffer[0];
+    mSize = mBuffer.size();
+    return true;
+#endif
+}
+
+//---------------------------------------------------------------------------
+bool Level::validate() const
+{
+    if (mSize < sizeof(LevelHeader))
+    {
+        return false;
+    }
+
+    const LevelHeader& header = getHeader();
+    if (header.magic != LEVEL_MAGIC || header.version != LEVEL_VERSION
+        || mSize != sizeof(LevelHeader)
+            + header.colliderCount * sizeof(LevelCollider)
+            + header.surfaceCount * sizeof(LevelSurface)
+            + header.lightCount * sizeof(LevelLight))
+    {
+        return false;
+    }
+
+    // Names are read as C strings straight from the mapping
+    if (!std::memchr(header.material, '\0', sizeof(header.material)))
+    {
+        return false;
+    }
+
+    const LevelSurface* surfaces = getSurfaces();
+    for (uint32_t i = 0; i < header.surfaceCount; ++i)
+    {
+        if (!std::memchr(surfaces[i].name, '\0', sizeof(surfaces[i].name)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void Level::unload()
+{
+#ifndef _WIN32
+    if (mMapped)
+    {
+        munmap(const_cast<char*>(mData), mSize);
+    }
+#endif
+
+    mData = 0;
+    mSize = 0;
+    mMapped = false;
+    mBuffer.clear();
+}
+
+//---------------------------------------------------------------------------
+// Reads count floats; false when the line has fewer
+static bool readFloats(std::istringstream& in, float* values, const int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (!(in >> values[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+static void appendRecord(std::vector<char>& out, const void* record, const size_t size)
+{
+    const char* bytes = static_cast<const char*>(record);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+//---------------------------------------------------------------------------
+bool Level::compile(const std::string& textFile, std::vector<char>& binary)
+{
+    std::ifstream file(textFile.c_str());
+    if (!file)
+    {
+        return false;
+    }
+
+    LevelHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = LEVEL_MAGIC;
+    header.version = LEVEL_VERSION;
+    header.spawnInterval = 1.0f;
+
+    std::vector<LevelCollider> colliders;
+    std::vector<LevelSurface> surfaces;
+    std::vector<LevelLight> lights;
+
+    std::string line;
+    int number = 0;
+    bool valid = true;
+
+    while (std::getline(file, line))
+    {
+        ++number;
+        line = line.substr(0, line.find('#'));
+
+        size_t split = line.find('=');
+        if (split == std::string::npos)
+        {
+            continue;
+        }
+
+        std::string key;
+        std::istringstream(line.substr(0, split)) >> key;
+        std::istringstream in(line.substr(split + 1));
+        bool read = true;
+
+        if (key == "Material")
+        {
+            std::string material;
+            in >> material;
+            std::strncpy(header.material, material.c_str(), sizeof(header.material) - 1);
+        }
+        else if (key == "Ambient")
+        {
+            read = readFloats(in, header.ambient, 3);
+        }
+        else if (key == "Bounds")
+        {
+            read = readFloats(in, header.boundsMin, 3) && readFloats(in, header.boundsMax, 3);
+        }
+        else if (key == "PlayBox")
+        {
+            read = readFloats(in, header.playMin, 3) && readFloats(in, header.playMax, 3);
+        }
+        else if (key == "SpawnInterval")
+        {
+            read = readFloats(in, &header.spawnInterval, 1);
+        }
+        else if (key == "Plane")
+        {
+            LevelCollider collider;
+            std::memset(&collider, 0, sizeof(collider));
+            collider.type = LEVEL_PLANE;
+            read = readFloats(in, collider.normal, 3) && readFloats(in, collider.position, 3);
+            colliders.push_back(collider);
+        }
+        else if (key == "Box")
+        {
+            LevelCollider collider;
+            std::memset(&collider, 0, sizeof(collider));
+            collider.type = LEVEL_BOX;
+            read = readFloats(in, collider.position, 3) && readFloats(in, collider.halfExtents, 3);
+            colliders.push_back(collider);
+        }
+        else if (key == "Surface")
+        {
+            LevelSurface surface;
+            std::memset(&surface, 0, sizeof(surface));
+
+            std::string name;
+            in >> name;
+            std::strncpy(surface.name, name.c_str(), sizeof(surface.name) - 1);
+
+            read = !name.empty() && readFloats(in, surface.position, 3)
+                && readFloats(in, &surface.height, 1) && readFloats(in, &surface.width, 1)
+                && readFloats(in, surface.facing, 3) && readFloats(in, surface.up, 3);
+            surfaces.push_back(surface);
+        }
+        else if (key == "Light")
+        {
+            LevelLight light;
+            std::memset(&light, 0, sizeof(light));
+
+            std::string type;
+            in >> type;
+            if (type == "point")
+            {
+                light.type = LEVEL_POINT;
+            }
+            else if (type == "directional")
+            {
+                light.type = LEVEL_DIRECTIONAL;
+            }
+            else
+            {
+                std::cerr << textFile << ":" << number << ": unknown light type "
+                    << type << std::endl;
+                valid = false;
+            }
+
+            read = readFloats(in, light.vector, 3) && readFloats(in, light.colour, 3);
+            lights.push_back(light);
+        }
+        else
+        {
+            std::cerr << textFile << ":" << number << ": unknown key " << key << std::endl;
+            valid = false;
+            continue;
+        }
+
+        if (!read)
+        {
+            std::cerr << textFile << ":" << number << ": missing values for " << key << std::endl;
+            valid = false;
+        }
+    }
+
+    if (!valid)
+    {
+        return false;
+    }
+
+    header.colliderCount = uint32_t(colliders.size());
+    header.surfaceCount = uint32_t(surfaces.size());
+    header.lightCount = uint32_t(lights.size());
+
+    binary.clear();
+    appendRecord(binary, &header, sizeof(header));
+    for (size_t i = 0; i < colliders.size(); ++i)
+    {
+        appendRecord(binary, &colliders[i], sizeof(LevelCollider));
+    }
+    for (size_t i = 0; i < surfaces.size(); ++i)
+    {
+        appendRecord(binary, &surfaces[i], sizeof(LevelSurface));
+    }
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        appendRecord(binary, &lights[i], sizeof(LevelLight));
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+const LevelHeader& Level::getHeader() const
+{
+    return *reinterpret_cast<const LevelHeader*>(mData);
+}
+
+//---------------------------------------------------------------------------
+const LevelCollider* Level::getColliders() const
+{
+    return reinterpret_cast<const LevelCollider*>(mData + sizeof(LevelHeader));
+}
+
+//---------------------------------------------------------------------------
+const LevelSurface* Level::getSurfaces() const
+{
+    return reinterpret_cast<const LevelSurface*>(getColliders() + getHeader().colliderCount);
+}
+
+//---------------------------------------------------------------------------
+const LevelLight* Level::getLights() const
+{
+    return reinterpret_cast<const LevelLight*>(getSurfaces() + getHeader().surfaceCount);
+}
+
+//---------------------------------------------------------------------------
+btVector3 Level::getBoundsMin() const
+{
+    const float* v = getHeader().boundsMin;
+    return btVector3(v[0], v[1], v[2]);
+}
+
+//---------------------------------------------------------------------------
+btVector3 Level::getBoundsMax() const
+{
+    const float* v = getHeader().boundsMax;
+    return btVector3(v[0], v[1], v[2]);
+}
+
+//---------------------------------------------------------------------------
+btVector3 Level::getPlayMin() const
+{
+    const float* v = getHeader().playMin;
+    return btVector3(v[0], v[1], v[2]);
+}
+
+//---------------------------------------------------------------------------
+btVector3 Level::getPlayMax() const
+{
+    const float* v = getHeader().playMax;
+    return btVector3(v[0], v[1], v[2]);
+}
@@ -0,0 +1,116 @@
+#ifndef Level_hpp
+#define Level_hpp
+
+#include <btBulletDynamicsCommon.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define LEVEL_FILE "arena.level"
+#define LEVEL_BINARY_FILE "arena.bin"
+#define LEVEL_MAGIC 0x564c4344 // "DCLV" in a little-endian file
+#define LEVEL_VERSION 1
+#define LEVEL_NAME_LENGTH 32
+
+enum LevelColliderType
+{
+    LEVEL_PLANE, // Infinite static plane through position, facing normal
+    LEVEL_BOX // Box around position with the given half extents
+};
+
+enum LevelLightType
+{
+    LEVEL_DIRECTIONAL,
+    LEVEL_POINT
+};
+
+// The compiled file is this header followed by the collider, surface and
+// light arrays, in that order, all plain floats in native byte order. It is
+// mapped and read in place.
+struct LevelHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t colliderCount;
+    uint32_t surfaceCount;
+    uint32_t lightCount;
+
+    char material[2 * LEVEL_NAME_LENGTH]; // Of every render surface
+    float ambient[3];
+    float boundsMin[3]; // Inside of the walls
+    float boundsMax[3];
+    float playMin[3]; // Cats outside this box have left the arena
+    float playMax[3];
+    float spawnInterval; // Seconds between cat launches
+};
+
+struct LevelCollider
+{
+    uint32_t type;
+    float position[3];
+    float halfExtents[3];
+    float normal[3];
+};
+
+// A textured plane, as Wall::createWall takes it
+struct LevelSurface
+{
+    char name[LEVEL_NAME_LENGTH];
+    float position[3];
+    float height;
+    float width;
+    float facing[3];
+    float up[3];
+};
+
+struct LevelLight
+{
+    uint32_t type;
+    float vector[3]; // Direction, or position for a point light
+    float colour[3];
+};
+
+// An arena read from a level file. The text form is compiled to a binary
+// one the first time it is loaded, or whenever the text is newer, and the
+// binary is memory-mapped so the arrays are used without a copy. Shipping
+// only the binary works too.
+class Level
+{
+public:
+    Level();
+    ~Level();
+
+    // False when neither file gives a valid level
+    bool load(const std::string& textFile = LEVEL_FILE,
+        const std::string& binaryFile = LEVEL_BINARY_FILE);
+
+    // Text to binary. Key=Value lines, '#' starts a comment; see arena.level.
+    static bool compile(const std::string& textFile, std::vector<char>& binary);
+
+    const LevelHeader& getHeader() const;
+    const LevelCollider* getColliders() const;
+    const LevelSurface* getSurfaces() const;
+    const LevelLight* getLights() const;
+
+    btVector3 getBoundsMin() const;
+    btVector3 getBoundsMax() const;
+    btVector3 getPlayMin() const;
+    btVector3 getPlayMax() const;
+
+private:
+    Level(const Level&);
+    Level& operator=(const Level&);
+
+    bool map(const std::string& binaryFile);
+    bool validate() const;
+    void unload();
+
+    const char* mData;
+    size_t mSize;
+    bool mMapped;
+    std::vector<char> mBuffer; // When the binary could not be mapped
+};
+
+#endif
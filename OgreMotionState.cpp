@@ -0,0 +1,96 @@
+#include "OgreMotionState.hpp"
+
+//---------------------------------------------------------------------------
+OgreMotionState::OgreMotionState(const btTransform& initialPos, Ogre::SceneNode* node,
+    BulletPhysics* physics)
+    : mVisibleObj(node),
+    mInstance(0),
+    mPhysicsEngine(physics),
+    mPrevPos(initialPos),
+    mPos(initialPos),
+    mQueued(false)
+{
+}
+
+//---------------------------------------------------------------------------
+OgreMotionState::~OgreMotionState()
+{
+}
+
+//---------------------------------------------------------------------------
+void OgreMotionState::setNode(Ogre::SceneNode* node)
+{
+    mVisibleObj = node;
+}
+
+//---------------------------------------------------------------------------
+Ogre::SceneNode* OgreMotionState::getNode()
+{
+    return mVisibleObj;
+}
+
+//---------------------------------------------------------------------------
+void OgreMotionState::setInstance(Ogre::InstancedEntity* instance, const Ogre::Quaternion& offset)
+{
+    mInstance = instance;
+    mInstanceOffset = offset;
+}
+
+//---------------------------------------------------------------------------
+void OgreMotionState::applyPose(const Ogre::Vector3& position, const Ogre::Quaternion& orientation)
+{
+    if (mInstance)
+    {
+        mInstance->setOrientation(orientation * mInstanceOffset);
+        mInstance->setPosition(position);
+    }
+    else if (mVisibleObj)
+    {
+        mVisibleObj->setOrientation(orientation);
+        mVisibleObj->setPosition(position);
+    }
+}
+
+//---------------------------------------------------------------------------
+void OgreMotionState::getWorldTransform(btTransform& worldTrans) const
+{
+    worldTrans = mPos;
+}
+
+//---------------------------------------------------------------------------
+void OgreMotionState::setWorldTransform(const btTransform& worldTrans)
+{
+    mPrevPos = mPos;
+    mPos = worldTrans;
+
+    if (!mQueued && (mVisibleObj || mInstance))
+    {
+        mQueued = true;
+        mPhysicsEngine->queueMotionStateSync(this);
+    }
+}
+
+//---------------------------------------------------------------------------
+void OgreMotionState::reset(const btTransform& worldTrans)
+{
+    setWorldTransform(worldTrans);
+    mPrevPos = worldTrans;
+}
+
+//---------------------------------------------------------------------------
+const btTransform& OgreMotionState::getPreviousTransform() const
+{
+    return mPrevPos;
+}
+
+//---------------------------------------------------------------------------
+const btTransform& OgreMotionState::getTransform() const
+{
+    return mPos;
+}
+
+//---------------------------------------------------------------------------
+void OgreMotionState::clearQueued()
+{
+    mQueued = false;
+}
@@ -0,0 +1,54 @@
+#ifndef OgreMotionState_hpp
+#define OgreMotionState_hpp
+
+#include "BulletPhysics.hpp"
+
+#include <OgreInstancedEntity.h>
+#include <OgreSceneNode.h>
+
+// Motion state that owns the scene node, or the instanced entity, of a rigid
+// body. Bullet only calls
+// setWorldTransform for bodies that moved during a step, so only those get
+// queued on the physics engine for a render sync. The last two physics poses
+// are kept so the node can be drawn in between them. Everything except the
+// node and instance pointers belongs to the physics thread.
+// Based on the MyMotionState sketch in Notes/bulletExample.cpp
+class OgreMotionState : public btMotionState
+{
+public:
+    OgreMotionState(const btTransform& initialPos, Ogre::SceneNode* node, BulletPhysics* physics);
+    virtual ~OgreMotionState();
+
+    void setNode(Ogre::SceneNode* node);
+    Ogre::SceneNode* getNode();
+
+    // Instanced bodies have no node. offset is the mesh's rotation relative
+    // to the body, applied on top of the body's own.
+    void setInstance(Ogre::InstancedEntity* instance, const Ogre::Quaternion& offset);
+
+    // Moves the node or instance to a pose (render thread)
+    void applyPose(const Ogre::Vector3& position, const Ogre::Quaternion& orientation);
+
+    virtual void getWorldTransform(btTransform& worldTrans) const;
+    virtual void setWorldTransform(const btTransform& worldTrans);
+
+    // Teleports the body: both poses are set so nothing is interpolated
+    void reset(const btTransform& worldTrans);
+
+    const btTransform& getPreviousTransform() const;
+    const btTransform& getTransform() const;
+
+    // Called once the queued sync has been copied into a snapshot
+    void clearQueued();
+
+protected:
+    Ogre::SceneNode* mVisibleObj;
+    Ogre::InstancedEntity* mInstance;
+    Ogre::Quaternion mInstanceOffset;
+    BulletPhysics* mPhysicsEngine;
+    btTransform mPrevPos;
+    btTransform mPos;
+    bool mQueued;
+};
+
+#endif
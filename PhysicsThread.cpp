@@ -0,0 +1,463 @@
+#include "PhysicsThread.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+//---------------------------------------------------------------------------
+PhysicsSnapshot::PhysicsSnapshot()
+    : playerHit(false),
+    stepTime(0.0),
+    physicsTime(0.0),
+    hitScanTime(0.0),
+    totalSteps(0),
+    droppedSteps(0),
+    averageStepTime(0.0),
+    maxStepTime(0.0),
+    averageBusyTime(0.0),
+    inputLatency(0.0),
+    averageInputLatency(0.0),
+    inputTime(0.0),
+    replayFinished(false)
+{
+    playerPrevious.setIdentity();
+    playerCurrent.setIdentity();
+}
+
+//---------------------------------------------------------------------------
+void PhysicsSnapshot::clear()
+{
+    bodies.clear();
+    catEvents.clear();
+    sounds.clear();
+    playerHit = false;
+    physicsTime = 0.0;
+    hitScanTime = 0.0;
+    inputLatency = 0.0;
+    inputTime = 0.0;
+}
+
+//---------------------------------------------------------------------------
+void PhysicsSnapshot::merge(const PhysicsSnapshot& newer)
+{
+    std::unordered_map<OgreMotionState*, size_t> index;
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        index[bodies[i].state] = i;
+    }
+
+    for (size_t i = 0; i < newer.bodies.size(); ++i)
+    {
+        std::unordered_map<OgreMotionState*, size_t>::iterator it =
+            index.find(newer.bodies[i].state);
+
+        if (it == index.end())
+        {
+            bodies.push_back(newer.bodies[i]);
+        }
+        else
+        {
+            bodies[it->second] = newer.bodies[i];
+        }
+    }
+
+    // Events keep their order so a cat retired and relaunched stays visible
+    catEvents.insert(catEvents.end(), newer.catEvents.begin(), newer.catEvents.end());
+    sounds.insert(sounds.end(), newer.sounds.begin(), newer.sounds.end());
+
+    playerPrevious = newer.playerPrevious;
+    playerCurrent = newer.playerCurrent;
+    playerHit = playerHit || newer.playerHit;
+    stepTime = newer.stepTime;
+    physicsTime += newer.physicsTime;
+    hitScanTime += newer.hitScanTime;
+
+    totalSteps = newer.totalSteps;
+    droppedSteps = newer.droppedSteps;
+    averageStepTime = newer.averageStepTime;
+    maxStepTime = newer.maxStepTime;
+    averageBusyTime = newer.averageBusyTime;
+
+    inputLatency = std::max(inputLatency, newer.inputLatency);
+    averageInputLatency = newer.averageInputLatency;
+    inputTime = std::max(inputTime, newer.inputTime);
+    replayFinished = replayFinished || newer.replayFinished;
+}
+
+//---------------------------------------------------------------------------
+PhysicsThread::PhysicsThread(Simulation* sim, BulletPhysics* physics, CatPool* pool,
+    Player* player)
+    : mSimulation(sim),
+    mPhysicsEngine(physics),
+    mCatPool(pool),
+    mPlayer(player),
+    mDroppedCommands(0),
+    mRecorder(0),
+    mReplay(0),
+    mPendingSpawns(0),
+    mHit(false),
+    mAverageBusyTime(0.0),
+    mPhysicsTime(0.0),
+    mHitScanTime(0.0),
+    mInputLatency(0.0),
+    mAverageInputLatency(0.0),
+    mInputTime(0.0),
+    mFresh(false),
+    mClockStart(std::chrono::steady_clock::now()),
+    mRunning(false)
+{
+    mPendingCommands.reserve(PHYSICS_COMMAND_QUEUE_SIZE);
+
+    mPlayerPrevious = mPlayer->getWorldTransform();
+    mFront.playerPrevious = mPlayerPrevious;
+    mFront.playerCurrent = mPlayerPrevious;
+}
+
+//---------------------------------------------------------------------------
+PhysicsThread::~PhysicsThread()
+{
+    stop();
+}
+
+//---------------------------------------------------------------------------
+void PhysicsThread::start()
+{
+    if (mRunning)
+    {
+        return;
+    }
+
+    mRunning = true;
+    mThread = std::thread(&PhysicsThread::run, this);
+}
+
+//---------------------------------------------------------------------------
+void PhysicsThread::stop()
+{
+    mRunning = false;
+
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+}
+
+//---------------------------------------------------------------------------
+bool PhysicsThread::isThreaded() const
+{
+    return mThread.joinable();
+}
+
+//---------------------------------------------------------------------------
+void PhysicsThread::update(const double frameTime)
+{
+    runSteps(frameTime);
+}
+
+//---------------------------------------------------------------------------
+void PhysicsThread::run()
+{
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+
+    while (mRunning)
+    {
+        std::chrono::steady_clock::time_point loopStart = std::chrono::steady_clock::now();
+        double frameTime = std::chrono::duration<double>(loopStart - last).count();
+        last = loopStart;
+
+        runSteps(frameTime);
+
+        double busy = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - loopStart).count();
+        mAverageBusyTime += (busy - mAverageBusyTime) * 0.05;
+
+        // Sleep until the next step is due
+        double wait = (1.0 - mTimestep.getAlpha()) * mTimestep.getStep();
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+    }
+}
+
+//---------------------------------------------------------------------------
+void PhysicsThread::runSteps(const double frameTime)
+{
+    PlayerCommand cmd;
+    while (mCommands.pop(cmd))
+    {
+        mPendingCommands.push_back(cmd);
+    }
+
+    if (mHit)
+    {
+        mPendingCommands.clear();
+        return;
+    }
+
+    if (mReplay)
+    {
+        mPendingCommands.clear();
+        if (mReplay->isFinished())
+        {
+            return;
+        }
+    }
+
+    int steps = mTimestep.advance(frameTime);
+    double clock = InputBuffer::now();
+
+    for (int i = 0; i < steps; ++i)
+    {
+        PlayerCommand stepCmd;
+
+        if (mReplay)
+        {
+            if (!mReplay->next(stepCmd))
+            {
+                break;
+            }
+        }
+        else
+        {
+            // Steps that catch up stand for earlier moments, the last one for now
+            applyCommands(clock - (steps - 1 - i) * mTimestep.getStep());
+
+            stepCmd = mInput;
+            if (mPendingSpawns > 0)
+            {
+                stepCmd.spawnCat = true;
+                --mPendingSpawns;
+            }
+        }
+
+        if (mRecorder)
+        {
+            mRecorder->append(stepCmd);
+        }
+
+        mPlayerPrevious = mPlayer->getWorldTransform();
+
+        bool alive = mSimulation->step(stepCmd, mTimestep.getStep());
+        mTimestep.recordStepTime(mSimulation->getLastStepTime());
+        mPhysicsTime += mSimulation->getLastStepTime();
+        mHitScanTime += mSimulation->getLastHitScanTime();
+
+        if (!alive)
+        {
+            mHit = true;
+            break;
+        }
+    }
+
+    if (steps > 0)
+    {
+        publish();
+    }
+}
+
+//---------------------------------------------------------------------------
+void PhysicsThread::applyCommands(const double stepClock)
+{
+    double now = InputBuffer::now();
+    size_t applied = 0;
+
+    while (applied < mPendingCommands.size() && mPendingCommands[applied].time <= stepClock)
+    {
+        const PlayerCommand& cmd = mPendingCommands[applied++];
+
+        if (cmd.spawnCat)
+        {
+            ++mPendingSpawns;
+        }
+
+        // Held keys and the cannon pitch follow the latest command
+        mInput = cmd;
+        mInput.spawnCat = false;
+
+        // Timer spawns carry no input time
+        if (cmd.time != 0.0)
+        {
+            double latency = (now - cmd.time) * 1000.0;
+            mInputLatency = std::max(mInputLatency, latency);
+            mAverageInputLatency += (latency - mAverageInputLatency) * 0.05;
+            mInputTime = std::max(mInputTime, cmd.time);
+        }
+    }
+
+    mPendingCommands.erase(mPendingCommands.begin(), mPendingCommands.begin() + applied);
+}
+
+//---------------------------------------------------------------------------
+void PhysicsThread::publish()
+{
+    std::vector<OgreMotionState*>& pending = mPhysicsEngine->getPendingSyncs();
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        BodySnapshot body;
+        body.state = pending[i];
+        body.previous = pending[i]->getPreviousTransform();
+        body.current = pending[i]->getTransform();
+        mBack.bodies.push_back(body);
+
+        pending[i]->clearQueued();
+    }
+    pending.clear();
+
+    mCatPool->takeEvents(mBack.catEvents);
+    if (mSimulation->getContactSounds())
+    {
+        mSimulation->getContactSounds()->takeEvents(mBack.sounds);
+    }
+
+    mBack.playerPrevious = mPlayerPrevious;
+    mBack.playerCurrent = mPlayer->getWorldTransform();
+    mBack.playerHit = mHit;
+    mBack.stepTime = now();
+    mBack.physicsTime = mPhysicsTime;
+    mBack.hitScanTime = mHitScanTime;
+    mBack.inputLatency = mInputLatency;
+    mBack.averageInputLatency = mAverageInputLatency;
+    mBack.inputTime = mInputTime;
+    mBack.replayFinished = mReplay && mReplay->isFinished();
+    mPhysicsTime = 0.0;
+    mHitScanTime = 0.0;
+    mInputLatency = 0.0;
+    mInputTime = 0.0;
+
+    mBack.totalSteps = mTimestep.getTotalSteps();
+    mBack.droppedSteps = mTimestep.getDroppedSteps();
+    mBack.averageStepTime = mTimestep.getAverageStepTime();
+    mBack.maxStepTime = mTimestep.getMaxStepTime();
+    mBack.averageBusyTime = mAverageBusyTime;
+
+    {
+        std::lock_guard<std::mutex> lock(mSnapshotMutex);
+
+        if (mFresh)
+        {
+            // The render thread has not read the last one yet
+            mHandoff.merge(mBack);
+        }
+        else
+        {
+            std::swap(mBack, mHandoff);
+            mFresh = true;
+        }
+    }
+
+    mBack.clear();
+}
+
+//---------------------------------------------------------------------------
+bool PhysicsThread::pushCommand(const PlayerCommand& cmd)
+{
+    if (!mCommands.push(cmd))
+    {
+        ++mDroppedCommands;
+        return false;
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+bool PhysicsThread::consumeSnapshot()
+{
+    std::lock_guard<std::mutex> lock(mSnapshotMutex);
+
+    if (!mFresh)
+    {
+        return false;
+    }
+
+    std::swap(mFront, mHandoff);
+    mFresh = false;
+    return true;
+}
+
+//---------------------------------------------------------------------------
+const PhysicsSnapshot& PhysicsThread::getSnapshot() const
+{
+    return mFront;
+}
+
+//---------------------------------------------------------------------------
+float PhysicsThread::getAlpha() const
+{
+    if (!isThreaded())
+    {
+        return mTimestep.getAlpha();
+    }
+
+    double alpha = (now() - mFront.stepTime) / mTimestep.getStep();
+    return std::min(1.0, std::max(0.0, alpha));
+}
+
+//---------------------------------------------------------------------------
+unsigned long PhysicsThread::getDroppedCommands() const
+{
+    return mDroppedCommands;
+}
+
+//---------------------------------------------------------------------------
+FixedTimestep& PhysicsThread::getTimestep()
+{
+    return mTimestep;
+}
+
+//---------------------------------------------------------------------------
+void PhysicsThread::setRecorder(InputRecording* recording)
+{
+    mRecorder = recording;
+}
+
+//---------------------------------------------------------------------------
+void PhysicsThread::setReplay(InputRecording* recording)
+{
+    mReplay = recording;
+}
+
+//---------------------------------------------------------------------------
+bool PhysicsThread::saveState(const std::string& fileName)
+{
+    bool threaded = isThreaded();
+    stop();
+
+    // Same object count as a load expects, whether or not the thread prewarmed
+    mCatPool->prewarm();
+    bool saved = mPhysicsEngine->saveState(fileName);
+
+    if (threaded)
+    {
+        start();
+    }
+    return saved;
+}
+
+//---------------------------------------------------------------------------
+bool PhysicsThread::loadState(const std::string& fileName)
+{
+    bool threaded = isThreaded();
+    stop();
+
+    mCatPool->prewarm();
+    bool loaded = mPhysicsEngine->loadState(fileName);
+
+    if (loaded)
+    {
+        mCatPool->syncWithWorld();
+        mPendingCommands.clear();
+        mPlayerPrevious = mPlayer->getWorldTransform();
+        mHit = false;
+        publish();
+    }
+
+    if (threaded)
+    {
+        start();
+    }
+    return loaded;
+}
+
+//---------------------------------------------------------------------------
+double PhysicsThread::now() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - mClockStart).count();
+}
@@ -0,0 +1,161 @@
+#ifndef PhysicsThread_hpp
+#define PhysicsThread_hpp
+
+#include "BulletPhysics.hpp"
+#include "CatPool.hpp"
+#include "FixedTimestep.hpp"
+#include "InputBuffer.hpp"
+#include "InputRecording.hpp"
+#include "OgreMotionState.hpp"
+#include "Player.hpp"
+#include "PlayerCommand.hpp"
+#include "Simulation.hpp"
+#include "SpscQueue.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define PHYSICS_COMMAND_QUEUE_SIZE 256
+#define PHYSICS_CHECKPOINT_FILE "checkpoint.state" // F5 saves, F9 loads
+
+// Pose of one body that moved, as of the last step
+struct BodySnapshot
+{
+    OgreMotionState* state;
+    btTransform previous;
+    btTransform current;
+};
+
+// What the render thread needs from the physics steps since its last read
+struct PhysicsSnapshot
+{
+    PhysicsSnapshot();
+
+    void clear();
+    // Folds a newer snapshot into this one when the render thread missed this one
+    void merge(const PhysicsSnapshot& newer);
+
+    std::vector<BodySnapshot> bodies;
+    std::vector<CatEvent> catEvents;
+    std::vector<SoundEvent> sounds;
+
+    btTransform playerPrevious;
+    btTransform playerCurrent;
+    bool playerHit;
+
+    // Seconds since the physics clock started, when the current poses were stepped
+    double stepTime;
+
+    // Milliseconds spent in stepSimulation and the hit scan since the last read
+    double physicsTime;
+    double hitScanTime;
+
+    // Physics thread timing, milliseconds
+    unsigned long totalSteps;
+    unsigned long droppedSteps;
+    double averageStepTime;
+    double maxStepTime;
+    double averageBusyTime;
+
+    // Milliseconds from an input event to the step that applied it
+    double inputLatency; // Worst since the last read
+    double averageInputLatency;
+    // Input clock time of the newest input the steps applied, 0 for none
+    double inputTime;
+
+    // A replay ran out of recorded steps
+    bool replayFinished;
+};
+
+// Owns the dynamics world while the game runs. Input arrives as timestamped
+// commands through a lock-free queue and each one is applied at the first
+// step due after it happened; results leave as snapshots. The physics side
+// fills one snapshot while the render side reads another, and a hand-off
+// slot guarded by a short lock lets them swap without waiting on each other.
+// Without start() the same steps run inline from update().
+class PhysicsThread
+{
+public:
+    PhysicsThread(Simulation* sim, BulletPhysics* physics, CatPool* pool, Player* player);
+    ~PhysicsThread();
+
+    void start();
+    void stop();
+    bool isThreaded() const;
+
+    // Inline mode: runs the steps that are due on the calling thread
+    void update(const double frameTime);
+
+    // Render side
+    bool pushCommand(const PlayerCommand& cmd);
+    // Takes the latest published snapshot; false when nothing new arrived
+    bool consumeSnapshot();
+    const PhysicsSnapshot& getSnapshot() const;
+    // How far rendering is between the snapshot's previous and current poses
+    float getAlpha() const;
+
+    unsigned long getDroppedCommands() const;
+
+    // Only safe to touch while the thread is stopped
+    FixedTimestep& getTimestep();
+    // Appends the command of every step to recording
+    void setRecorder(InputRecording* recording);
+    // Steps run the recorded commands and live input is ignored
+    void setReplay(InputRecording* recording);
+
+    // World checkpoints (render thread). The thread is paused around them.
+    // Both build the whole cat pool first so the states line up, and loading
+    // publishes the restored poses.
+    bool saveState(const std::string& fileName);
+    bool loadState(const std::string& fileName);
+
+private:
+    void run();
+    void runSteps(const double frameTime);
+    void applyCommands(const double stepClock);
+    void publish();
+    double now() const;
+
+    Simulation* mSimulation;
+    BulletPhysics* mPhysicsEngine;
+    CatPool* mCatPool;
+    Player* mPlayer;
+
+    FixedTimestep mTimestep;
+    SpscQueue<PlayerCommand, PHYSICS_COMMAND_QUEUE_SIZE> mCommands;
+    std::atomic<unsigned long> mDroppedCommands;
+
+    // Physics side
+    PlayerCommand mInput;
+    InputRecording* mRecorder;
+    InputRecording* mReplay;
+    std::vector<PlayerCommand> mPendingCommands; // Drained, not yet due
+    int mPendingSpawns;
+    bool mHit;
+    btTransform mPlayerPrevious;
+    double mAverageBusyTime;
+    double mPhysicsTime;
+    double mHitScanTime;
+    double mInputLatency;
+    double mAverageInputLatency;
+    double mInputTime;
+    PhysicsSnapshot mBack;
+
+    // Hand-off
+    std::mutex mSnapshotMutex;
+    PhysicsSnapshot mHandoff;
+    bool mFresh;
+
+    // Render side
+    PhysicsSnapshot mFront;
+
+    std::chrono::steady_clock::time_point mClockStart;
+    std::atomic<bool> mRunning;
+    std::thread mThread;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "Player.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
 
@@ -11,54 +12,67 @@
 #define PADDLE_OFFSET 110.0
 
 Player::Player (Ogre::String name, Ogre::SceneManager *sceneMgr, BulletPhysics* physicsEngine, Sound* sound) 
+    : mCannonPitch(btQuaternion::getIdentity()),
+    mMainNode(0),
+    mCannonNode(0),
+    mSightNode(0),
+    mCameraNode(0),
+    mEntity(0)
 {
+    std::fill(mHeldKeys, mHeldKeys + INPUT_ACTION_COUNT, 0);
+
     // Setup basic member references
     mName = name;
     mSceneMgr = sceneMgr;
 
     mSound = sound;
 
-    // Setup basic node structure to handle 3rd person cameras
-    mMainNode = mSceneMgr->getRootSceneNode ()->createChildSceneNode (mName);
-    mSightNode = mMainNode->createChildSceneNode (mName + "_sight", Ogre::Vector3 (0, 0, -200));
-    mCameraNode = mMainNode->createChildSceneNode (mName + "_camera", Ogre::Vector3 (0, 300, 500));
-
-    // Give this character a shape :)
-    Ogre::MeshManager::getSingleton()
-      .create("cannon/CannonBase.mesh",
-              Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
-    Ogre::MeshManager::getSingleton()
-      .create("cannon/CannonSpray.mesh",
-              Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
-
-    Ogre::Entity* baseEntity =
-      mSceneMgr
-      ->createEntity(Ogre::MeshManager::getSingleton()
-                     .getByName("cannon/CannonBase.mesh",
-                                Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME));
-    Ogre::Entity* sprayEntity =
-      mSceneMgr
-      ->createEntity(Ogre::MeshManager::getSingleton()
-                     .getByName("cannon/CannonSpray.mesh",
-                                Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME));
-    Ogre::SceneNode* baseNode = mMainNode->createChildSceneNode();
-    mCannonNode = mMainNode->createChildSceneNode();
-
-    // Put the cannon base into position
-    baseNode->attachObject(baseEntity);
-    baseNode->roll(Ogre::Radian(Ogre::Degree(180)));
-    baseNode->yaw(Ogre::Radian(Ogre::Degree(90)));
-
-    // Put the cannon and spray bottle into position
-    Ogre::SceneNode* cannonNode = mCannonNode->createChildSceneNode();
-    cannonNode->attachObject(sprayEntity);
-    cannonNode->roll(Ogre::Radian(Ogre::Degree(180)));
-    cannonNode->yaw(Ogre::Radian(Ogre::Degree(180)));
-    cannonNode->translate(Ogre::Vector3(0.0, 100.0, 0.0));
-    cannonNode->scale(Ogre::Vector3(0.77, 0.77, 0.77));
-
-    // Scale both parts of the cannon
-    mMainNode->scale(Ogre::Vector3(0.6, 0.6, 0.6));
+    // Headless runs have no scene, only the physics body and paddle
+    if (mSceneMgr)
+    {
+        // Setup basic node structure to handle 3rd person cameras
+        mMainNode = mSceneMgr->getRootSceneNode ()->createChildSceneNode (mName);
+        mSightNode = mMainNode->createChildSceneNode (mName + "_sight", Ogre::Vector3 (0, 0, -200));
+        mCameraNode = mMainNode->createChildSceneNode (mName + "_camera", Ogre::Vector3 (0, 300, 500));
+
+        // Give this character a shape :)
+        // Loading reuses the meshes if they were already prepared
+        Ogre::MeshManager::getSingleton()
+          .load("cannon/CannonBase.mesh",
+                  Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+        Ogre::MeshManager::getSingleton()
+          .load("cannon/CannonSpray.mesh",
+                  Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+
+        Ogre::Entity* baseEntity =
+          mSceneMgr
+          ->createEntity(Ogre::MeshManager::getSingleton()
+                         .getByName("cannon/CannonBase.mesh",
+                                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME));
+        Ogre::Entity* sprayEntity =
+          mSceneMgr
+          ->createEntity(Ogre::MeshManager::getSingleton()
+                         .getByName("cannon/CannonSpray.mesh",
+                                    Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME));
+        Ogre::SceneNode* baseNode = mMainNode->createChildSceneNode();
+        mCannonNode = mMainNode->createChildSceneNode();
+
+        // Put the cannon base into position
+        baseNode->attachObject(baseEntity);
+        baseNode->roll(Ogre::Radian(Ogre::Degree(180)));
+        baseNode->yaw(Ogre::Radian(Ogre::Degree(90)));
+
+        // Put the cannon and spray bottle into position
+        Ogre::SceneNode* cannonNode = mCannonNode->createChildSceneNode();
+        cannonNode->attachObject(sprayEntity);
+        cannonNode->roll(Ogre::Radian(Ogre::Degree(180)));
+        cannonNode->yaw(Ogre::Radian(Ogre::Degree(180)));
+        cannonNode->translate(Ogre::Vector3(0.0, 100.0, 0.0));
+        cannonNode->scale(Ogre::Vector3(0.77, 0.77, 0.77));
+
+        // Scale both parts of the cannon
+        mMainNode->scale(Ogre::Vector3(0.6, 0.6, 0.6));
+    }
 
     btBoxShape* boxShape = new btBoxShape(btVector3(40.0, 70.0, 40.0));
 
@@ -73,8 +87,8 @@ Player::Player (Ogre::String name, Ogre::SceneManager *sceneMgr, BulletPhysics*
     ghost->setCollisionFlags(btCollisionObject::CF_CHARACTER_OBJECT);
     player = new btKinematicCharacterController(ghost, boxShape, 1.0);
     physicsEngine->getDynamicsWorld()->addCollisionObject(ghost,
-                                                          btBroadphaseProxy::CharacterFilter,
-                                                          btBroadphaseProxy::StaticFilter | btBroadphaseProxy::DefaultFilter);
+                                                          COL_PLAYER,
+                                                          COL_PLAYER_MASK);
     physicsEngine->getDynamicsWorld()->addAction(player);
 
     btVector3 trans = ghost->getWorldTransform().getOrigin();
@@ -98,7 +112,10 @@ Player::Player (Ogre::String name, Ogre::SceneManager *sceneMgr, BulletPhysics*
     paddleBody = new btRigidBody(boxRBInfo);
     paddleBody->setRestitution(1.0);
 
-    physicsEngine->getDynamicsWorld()->addRigidBody(paddleBody);
+    physicsEngine->getDynamicsWorld()->addRigidBody(paddleBody, COL_PADDLE, COL_PADDLE_MASK);
+
+    physicsEngine->trackStateObject(ghost);
+    physicsEngine->trackStateObject(paddleBody);
 }
 
 Player::~Player ()
@@ -106,83 +123,150 @@ Player::~Player ()
     delete mEntity;
 }
 
-// Updates the Player (movement...)
-void Player::update (Ogre::Real elapsedTime, OIS::Keyboard* input, OIS::Mouse* mouse) 
+// Drains the buffered input events (render thread). Every key edge becomes a
+// command stamped with the time it happened, so a tap shorter than a frame
+// still reaches the simulation. Mouse movement is summed over the frame and
+// moves the camera-related nodes and the cannon; body movement is left to
+// applyCommand.
+void Player::applyInput (InputBuffer& input, std::vector<PlayerCommand>& commands)
 {
-    const OIS::MouseState& me = mouse->getMouseState();
-    
-    // Forward movement
-    if (input->isKeyDown (OIS::KC_W) || input->isKeyDown(OIS::KC_COMMA) || input->isKeyDown(OIS::KC_UP))
+    size_t first = commands.size();
+    float pitchDelta = 0.0f;
+    double pitchTime = 0.0;
+
+    InputEvent event;
+    while (input.pop(event))
     {
-        Ogre::Quaternion orientation = mMainNode->getOrientation();
-        Ogre::Vector3 direction = orientation * Ogre::Vector3(0, 0, -WALK_SPEED); // * elapsedTime);
-        
-        // Create bullet vector 3 where it will be moving
-        btVector3 move(direction.x, direction.y, direction.z);
+        if (event.action == INPUT_PITCH)
+        {
+            if (pitchTime == 0.0)
+            {
+                pitchTime = event.time;
+            }
+            pitchDelta += event.delta;
+            continue;
+        }
 
-        // Update the player via bullet. Vector it will move along and how far they will move per second
-        player->setVelocityForTimeInterval(move, elapsedTime * FPS);
+        // Several keys share an action, it is held while any of them is down
+        mHeldKeys[event.action] = std::max(0, mHeldKeys[event.action] + (event.pressed ? 1 : -1));
+
+        PlayerCommand cmd = currentCommand();
+        cmd.time = event.time;
+        commands.push_back(cmd);
     }
-    // Backward Movement (same idea as in forward movement)
-    if (input->isKeyDown (OIS::KC_S) || input->isKeyDown(OIS::KC_O) || input->isKeyDown(OIS::KC_DOWN))
+
+    if (pitchDelta < -0.1f || pitchDelta > 0.1f)
     {
-        Ogre::Quaternion orientation = mMainNode->getOrientation();
-        Ogre::Vector3 direction = orientation * Ogre::Vector3(0, 0, WALK_SPEED);
-        btVector3 move(direction.x, direction.y, direction.z);
+        mSound->playSound(SOUND_MOVE);
+        pitchCamera(pitchDelta);
 
-        player->setVelocityForTimeInterval(move, elapsedTime * FPS);
+        PlayerCommand cmd = currentCommand();
+        cmd.time = pitchTime;
+        commands.push_back(cmd);
     }
 
-    // Camera movement based on mouse movement
-    if (me.Y.rel < -0.1f || me.Y.rel > 0.1f)
+    if (mHeldKeys[INPUT_TURN_LEFT] > 0 || mHeldKeys[INPUT_TURN_RIGHT] > 0)
     {
-        mSound->playSound("move");
+        mSound->playSound(SOUND_MOVE);
+    }
 
-        Ogre::Real upperCam = 600.0; // how high camera can go up
-        Ogre::Real upperSight = 500.0; // how high sight node can go up
-        Ogre::Real lower = 0.0; // how low each node can go
+    // Commands from this frame all aim where the cannon ended up
+    Ogre::Quaternion pitch = mCannonNode->getOrientation();
+    for (size_t i = first; i < commands.size(); ++i)
+    {
+        commands[i].cannonPitch = btQuaternion(pitch.x, pitch.y, pitch.z, pitch.w);
+    }
+}
 
-        // Get y of each node
-        Ogre::Real sightY = mSightNode->getPosition().y;
-        Ogre::Real camY = mCameraNode->getPosition().y;
+// Held movement keys and the cannon pitch as they are right now
+PlayerCommand Player::currentCommand () const
+{
+    PlayerCommand cmd;
 
-        // Find the new position of the nodes relative to y mouse movement and
-        // clamp using the bounds
-        sightY = std::max(lower, std::min(sightY - me.Y.rel * DAMPING_FACTOR, upperSight));
-        camY = std::max(lower, std::min(camY + me.Y.rel * DAMPING_FACTOR, upperCam));
+    cmd.forward = mHeldKeys[INPUT_FORWARD] > 0;
+    cmd.backward = mHeldKeys[INPUT_BACKWARD] > 0;
+    cmd.turnLeft = mHeldKeys[INPUT_TURN_LEFT] > 0;
+    cmd.turnRight = mHeldKeys[INPUT_TURN_RIGHT] > 0;
 
-        // Only update sight node if camera is less than or equal to 300 in y
-        if (camY <= 300.0f)
-        {
-            // Camera class relies on this...
-            mSightNode->setPosition(Ogre::Vector3(0, sightY, -200));
-        }
+    Ogre::Quaternion pitch = mCannonNode->getOrientation();
+    cmd.cannonPitch = btQuaternion(pitch.x, pitch.y, pitch.z, pitch.w);
 
-        // Only update camera node y position if sight node y position is less than 300
-        if (sightY <= 300.0f)
-        {
-            mCameraNode->setPosition(Ogre::Vector3(0, camY, 500));
-        }
-        // Sight node y pos is greater than 300 and cam node y == 0
-        else
-        {
-            // The x movement of cam should be 50% slower than the y movement of sight
-            Ogre::Real camZ = mCameraNode->getPosition().z;
-            camZ += me.Y.rel * DAMPING_FACTOR * 0.5f;
-            camZ = std::max(100.0f, std::min(camZ, 500.0f));
-            mCameraNode->setPosition(Ogre::Vector3(0, 0, camZ));
-        }
+    return cmd;
+}
+
+// Camera movement based on relative mouse Y movement
+void Player::pitchCamera (const float rel)
+{
+    Ogre::Real upperCam = 600.0; // how high camera can go up
+    Ogre::Real upperSight = 500.0; // how high sight node can go up
+    Ogre::Real lower = 0.0; // how low each node can go
+
+    // Get y of each node
+    Ogre::Real sightY = mSightNode->getPosition().y;
+    Ogre::Real camY = mCameraNode->getPosition().y;
+
+    // Find the new position of the nodes relative to y mouse movement and
+    // clamp using the bounds
+    sightY = std::max(lower, std::min(sightY - rel * DAMPING_FACTOR, upperSight));
+    camY = std::max(lower, std::min(camY + rel * DAMPING_FACTOR, upperCam));
 
-        // Rotate the cannon and spray bottle based on the location of the
-        // sight node and the camera node
-        Ogre::Degree pitch(mCannonNode->getOrientation().getPitch());
-        pitch -= Ogre::Degree(me.Y.rel * 0.03);
-        if (pitch < Ogre::Degree(85.0f) && pitch > Ogre::Degree(-10.0f))
-          mCannonNode->pitch(-Ogre::Radian(Ogre::Degree(me.Y.rel * 0.03)));
+    // Only update sight node if camera is less than or equal to 300 in y
+    if (camY <= 300.0f)
+    {
+        // Camera class relies on this...
+        mSightNode->setPosition(Ogre::Vector3(0, sightY, -200));
+    }
+
+    // Only update camera node y position if sight node y position is less than 300
+    if (sightY <= 300.0f)
+    {
+        mCameraNode->setPosition(Ogre::Vector3(0, camY, 500));
+    }
+    // Sight node y pos is greater than 300 and cam node y == 0
+    else
+    {
+        // The x movement of cam should be 50% slower than the y movement of sight
+        Ogre::Real camZ = mCameraNode->getPosition().z;
+        camZ += rel * DAMPING_FACTOR * 0.5f;
+        camZ = std::max(100.0f, std::min(camZ, 500.0f));
+        mCameraNode->setPosition(Ogre::Vector3(0, 0, camZ));
+    }
+
+    // Rotate the cannon and spray bottle based on the location of the
+    // sight node and the camera node
+    Ogre::Degree pitch(mCannonNode->getOrientation().getPitch());
+    pitch -= Ogre::Degree(rel * 0.03);
+    if (pitch < Ogre::Degree(85.0f) && pitch > Ogre::Degree(-10.0f))
+      mCannonNode->pitch(-Ogre::Radian(Ogre::Degree(rel * 0.03)));
+}
+
+// Moves the player in the physics world (physics thread), once per step
+void Player::applyCommand (const PlayerCommand& cmd, btScalar elapsedTime)
+{
+    mCannonPitch = cmd.cannonPitch;
+
+    // Forward movement
+    if (cmd.forward)
+    {
+        btQuaternion orientation = ghost->getWorldTransform().getRotation();
+
+        // Create bullet vector 3 where it will be moving
+        btVector3 move = quatRotate(orientation, btVector3(0, 0, -WALK_SPEED));
+
+        // Update the player via bullet. Vector it will move along and how far they will move per second
+        player->setVelocityForTimeInterval(move, elapsedTime * FPS);
+    }
+    // Backward Movement (same idea as in forward movement)
+    if (cmd.backward)
+    {
+        btQuaternion orientation = ghost->getWorldTransform().getRotation();
+        btVector3 move = quatRotate(orientation, btVector3(0, 0, WALK_SPEED));
+
+        player->setVelocityForTimeInterval(move, elapsedTime * FPS);
     }
 
     // Left rotation
-    if (input->isKeyDown (OIS::KC_A) || input->isKeyDown(OIS::KC_LEFT))
+    if (cmd.turnLeft)
     {
         // Ghost object is represenation of kinematic controller
         btTransform t = player->getGhostObject()->getWorldTransform();
@@ -199,11 +283,10 @@ void Player::update (Ogre::Real elapsedTime, OIS::Keyboard* input, OIS::Mouse* m
         // Set the results
         t.setRotation(orientation);
         player->getGhostObject()->setWorldTransform(t);
-        mSound->playSound("move");
     }
 
     // Right rotation
-    if (input->isKeyDown(OIS::KC_D) || input->isKeyDown(OIS::KC_E) || input->isKeyDown(OIS::KC_RIGHT))
+    if (cmd.turnRight)
     {
         btTransform t = player->getGhostObject()->getWorldTransform();
         btQuaternion orientation = t.getRotation();
@@ -218,24 +301,19 @@ void Player::update (Ogre::Real elapsedTime, OIS::Keyboard* input, OIS::Mouse* m
 
         t.setRotation(orientation);
         player->getGhostObject()->setWorldTransform(t);
-        mSound->playSound("move");
     }
 
-    Ogre::Quaternion orientation = mCannonNode->_getDerivedOrientation();
-
-    Ogre::Vector3 direction = orientation * Ogre::Vector3(0, 0, -PADDLE_OFFSET);
+    // The paddle follows the cannon
+    btTransform trans = ghost->getWorldTransform();
+    btQuaternion orientation = trans.getRotation() * mCannonPitch;
 
-    btVector3 move(direction.x, direction.y, direction.z);
+    btVector3 move = quatRotate(orientation, btVector3(0, 0, -PADDLE_OFFSET));
 
-    btTransform trans = ghost->getWorldTransform();
     btVector3 origin = trans.getOrigin() + move;
     if (origin.y() < PADDLE_HEIGHT / 2)
       origin.setY(PADDLE_HEIGHT / 2);
     trans.setOrigin(origin);
-    trans.setRotation(btQuaternion(orientation.x,
-                                   orientation.y,
-                                   orientation.z,
-                                   orientation.w));
+    trans.setRotation(orientation);
     paddleBody->setWorldTransform(trans);
 }
 
@@ -276,6 +354,12 @@ Ogre::Vector3 Player::getOgreLookDirection()
     return this->mCannonNode->_getDerivedOrientation() * Ogre::Vector3(0, 0, -1);
 }
 
+btVector3 Player::getLookDirection()
+{
+    btQuaternion orientation = this->ghost->getWorldTransform().getRotation() * this->mCannonPitch;
+    return quatRotate(orientation, btVector3(0, 0, -1));
+}
+
 void Player::setOgrePosition(Ogre::Vector3 vec) {
     this->mMainNode->translate(vec - mMainNode->_getDerivedPosition());
 }
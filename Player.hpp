@@ -13,18 +13,27 @@
 #include <BulletDynamics/Character/btKinematicCharacterController.h>
 #include <BulletCollision/CollisionDispatch/btGhostObject.h>
 
+#include <vector>
+
 #include "BulletPhysics.hpp"
+#include "InputBuffer.hpp"
+#include "PlayerCommand.hpp"
 #include "Sound.hpp"
 
 class Player
 {
 public:
+    // sceneMgr may be null, in which case no nodes or entities are created
     Player (Ogre::String name, Ogre::SceneManager* sceneMgr, BulletPhysics* physicsEngine, Sound* sound);
 
     ~Player ();
 
-    // Updates the Player (movement...)
-    void update (Ogre::Real elapsedTime, OIS::Keyboard* input, OIS::Mouse* mouse);
+    // Drains the buffered input into timestamped commands and moves the
+    // camera-related nodes (render thread)
+    void applyInput (InputBuffer& input, std::vector<PlayerCommand>& commands);
+
+    // Moves the player body and paddle for one physics step (physics thread)
+    void applyCommand (const PlayerCommand& cmd, btScalar elapsedTime);
 
     // The three methods below returns the two camera-related nodes, 
     // and the current position of the Player (for the 1st person camera)
@@ -41,14 +50,19 @@ public:
     void setOgreOrientation(Ogre::Quaternion q);
     Ogre::Vector3 getOgrePosition();
     Ogre::Vector3 getOgreLookDirection();
+    btVector3 getLookDirection();
 
     float getCollisionObjectHalfHeight();
 
 protected:
+    PlayerCommand currentCommand () const;
+    void pitchCamera (const float rel);
+
     Ogre::String mName;
     btPairCachingGhostObject* ghost;
     btKinematicCharacterController* player;
     btRigidBody* paddleBody;
+    btQuaternion mCannonPitch; // Cannon orientation relative to the body, physics side
     Ogre::SceneNode* mMainNode;
   Ogre::SceneNode* mCannonNode;
     Ogre::SceneNode* mSightNode; // "Sight" node - The Player is supposed to be looking here
@@ -57,6 +71,9 @@ protected:
     Ogre::SceneManager* mSceneMgr;
 
     Sound* mSound;
+
+    // Keys down per movement action, render side
+    int mHeldKeys[INPUT_ACTION_COUNT];
 };
 
 #endif
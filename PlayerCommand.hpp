@@ -0,0 +1,34 @@
+#ifndef PlayerCommand_hpp
+#define PlayerCommand_hpp
+
+#include <btBulletDynamicsCommon.h>
+
+// Everything the simulation needs from one change in the player's input.
+// Movement keys are held state; spawnCat is a one-shot request.
+struct PlayerCommand
+{
+    PlayerCommand()
+        : forward(false),
+        backward(false),
+        turnLeft(false),
+        turnRight(false),
+        spawnCat(false),
+        cannonPitch(btQuaternion::getIdentity()),
+        time(0.0)
+    {
+    }
+
+    bool forward;
+    bool backward;
+    bool turnLeft;
+    bool turnRight;
+    bool spawnCat;
+
+    // Cannon orientation relative to the player body
+    btQuaternion cannonPitch;
+
+    // Seconds on the input clock when the input happened; 0 applies at once
+    double time;
+};
+
+#endif
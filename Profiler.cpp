@@ -0,0 +1,184 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+//---------------------------------------------------------------------------
+Profiler::Profiler()
+    : mFrames(PROFILER_HISTORY),
+    mNext(0),
+    mCount(0),
+    mFrameNumber(0),
+    mSpikes(0),
+    mAverageFrame(0.0)
+{
+    std::fill(mCurrent.sections, mCurrent.sections + PROFILE_SECTION_COUNT, 0.0);
+}
+
+//---------------------------------------------------------------------------
+void Profiler::nextFrame(const double frameTime)
+{
+    mCurrent.sections[PROFILE_FRAME] = frameTime;
+
+    if (mFrameNumber > 0)
+    {
+        if (mCount == 0)
+        {
+            mAverageFrame = frameTime;
+        }
+        else if (frameTime > mAverageFrame * PROFILER_SPIKE_FACTOR)
+        {
+            ++mSpikes;
+        }
+        mAverageFrame += (frameTime - mAverageFrame) * 0.05;
+
+        mFrames[mNext] = mCurrent;
+        mNext = (mNext + 1) % mFrames.size();
+        mCount = std::min(mCount + 1, mFrames.size());
+    }
+
+    ++mFrameNumber;
+    std::fill(mCurrent.sections, mCurrent.sections + PROFILE_SECTION_COUNT, 0.0);
+}
+
+//---------------------------------------------------------------------------
+void Profiler::record(const ProfileSection section, const double milliseconds)
+{
+    mCurrent.sections[section] += milliseconds;
+}
+
+//---------------------------------------------------------------------------
+double Profiler::getAverage(const ProfileSection section) const
+{
+    if (mCount == 0)
+    {
+        return 0.0;
+    }
+
+    double total = 0.0;
+    for (size_t i = 0; i < mCount; ++i)
+    {
+        total += mFrames[i].sections[section];
+    }
+
+    return total / mCount;
+}
+
+//---------------------------------------------------------------------------
+double Profiler::getMax(const ProfileSection section) const
+{
+    double max = 0.0;
+    for (size_t i = 0; i < mCount; ++i)
+    {
+        max = std::max(max, mFrames[i].sections[section]);
+    }
+
+    return max;
+}
+
+//---------------------------------------------------------------------------
+size_t Profiler::getFrameCount() const
+{
+    return mCount;
+}
+
+//---------------------------------------------------------------------------
+unsigned long Profiler::getSpikes() const
+{
+    return mSpikes;
+}
+
+//---------------------------------------------------------------------------
+std::string Profiler::summary() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << "ms avg / max";
+
+    for (int i = 0; i < PROFILE_SECTION_COUNT; ++i)
+    {
+        ProfileSection section = static_cast<ProfileSection>(i);
+        out << "\n" << getSectionName(section) << ": "
+            << getAverage(section) << " / " << getMax(section);
+    }
+
+    out << "\nspikes: " << mSpikes;
+    return out.str();
+}
+
+//---------------------------------------------------------------------------
+bool Profiler::dump(const std::string& fileName) const
+{
+    std::ofstream file(fileName.c_str());
+    if (!file)
+    {
+        return false;
+    }
+
+    file << "frame";
+    for (int i = 0; i < PROFILE_SECTION_COUNT; ++i)
+    {
+        file << "," << getSectionName(static_cast<ProfileSection>(i)) << "_ms";
+    }
+    file << "\n";
+
+    // The oldest frame sits where the next one will be written once the ring is full
+    size_t first = mCount < mFrames.size() ? 0 : mNext;
+    unsigned long number = mFrameNumber - 1 - mCount;
+
+    for (size_t i = 0; i < mCount; ++i)
+    {
+        const ProfileFrame& frame = mFrames[(first + i) % mFrames.size()];
+
+        file << number + i;
+        for (int j = 0; j < PROFILE_SECTION_COUNT; ++j)
+        {
+            file << "," << frame.sections[j];
+        }
+        file << "\n";
+    }
+
+    return file.good();
+}
+
+//---------------------------------------------------------------------------
+const char* Profiler::getSectionName(const ProfileSection section)
+{
+    switch (section)
+    {
+        case PROFILE_FRAME:
+            return "frame";
+        case PROFILE_INPUT:
+            return "input";
+        case PROFILE_PLAYER:
+            return "player";
+        case PROFILE_PHYSICS:
+            return "physics";
+        case PROFILE_HIT_SCAN:
+            return "hit_scan";
+        case PROFILE_SYNC:
+            return "sync";
+        case PROFILE_GUI:
+            return "gui";
+        case PROFILE_INPUT_LATENCY:
+            return "input_latency";
+        default:
+            return "unknown";
+    }
+}
+
+//---------------------------------------------------------------------------
+ScopedTimer::ScopedTimer(Profiler& profiler, const ProfileSection section)
+    : mProfiler(profiler),
+    mSection(section),
+    mStart(std::chrono::high_resolution_clock::now())
+{
+}
+
+//---------------------------------------------------------------------------
+ScopedTimer::~ScopedTimer()
+{
+    mProfiler.record(mSection, std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - mStart).count());
+}
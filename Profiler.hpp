@@ -0,0 +1,82 @@
+#ifndef Profiler_hpp
+#define Profiler_hpp
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#define PROFILER_HISTORY 600 // Frames kept, ten seconds at 60 fps
+#define PROFILER_SPIKE_FACTOR 2.0 // A frame this many times the average is a spike
+#define PROFILER_DUMP_FILE "profile.csv"
+#define PROFILER_HUD_INTERVAL 15 // Frames between HUD refreshes
+
+// Parts of a frame that are timed. Physics sections are measured on the
+// physics thread and arrive with its snapshots.
+enum ProfileSection
+{
+    PROFILE_FRAME,
+    PROFILE_INPUT,
+    PROFILE_PLAYER,
+    PROFILE_PHYSICS,
+    PROFILE_HIT_SCAN,
+    PROFILE_SYNC,
+    PROFILE_GUI,
+    PROFILE_INPUT_LATENCY, // Worst input event to physics step, not part of the frame
+    PROFILE_SECTION_COUNT
+};
+
+struct ProfileFrame
+{
+    double sections[PROFILE_SECTION_COUNT]; // Milliseconds
+};
+
+// Keeps the section times of the last PROFILER_HISTORY frames in a ring
+// buffer. Render thread only.
+class Profiler
+{
+public:
+    Profiler();
+
+    // Closes the current frame with its total time and starts the next one
+    void nextFrame(const double frameTime);
+
+    // Adds time to a section of the current frame
+    void record(const ProfileSection section, const double milliseconds);
+
+    double getAverage(const ProfileSection section) const;
+    double getMax(const ProfileSection section) const;
+    size_t getFrameCount() const;
+    unsigned long getSpikes() const;
+
+    // One line per section, for the HUD
+    std::string summary() const;
+
+    // Writes the buffered frames, oldest first, as CSV
+    bool dump(const std::string& fileName) const;
+
+    static const char* getSectionName(const ProfileSection section);
+
+private:
+    std::vector<ProfileFrame> mFrames;
+    size_t mNext;
+    size_t mCount;
+    unsigned long mFrameNumber;
+    unsigned long mSpikes;
+    double mAverageFrame;
+    ProfileFrame mCurrent;
+};
+
+// Adds the time between construction and destruction to a profiler section
+class ScopedTimer
+{
+public:
+    ScopedTimer(Profiler& profiler, const ProfileSection section);
+    ~ScopedTimer();
+
+private:
+    Profiler& mProfiler;
+    ProfileSection mSection;
+    std::chrono::high_resolution_clock::time_point mStart;
+};
+
+#endif
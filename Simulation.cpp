@@ -0,0 +1,90 @@
+#include "Simulation.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+//---------------------------------------------------------------------------
+Simulation::Simulation(BulletPhysics* physics, Player* player, CatPool* pool,
+    CatDespawner* despawner, ContactSounds* sounds)
+    : mPhysicsEngine(physics),
+    mPlayer(player),
+    mCatPool(pool),
+    mCatDespawner(despawner),
+    mContactSounds(sounds),
+    mLastStepTime(0.0),
+    mLastHitScanTime(0.0),
+    mPlayerContacts(0)
+{
+    mPhysicsEngine->getContactDispatcher().addListener(COL_CAT, COL_PLAYER, this);
+}
+
+//---------------------------------------------------------------------------
+Simulation::~Simulation()
+{
+    mPhysicsEngine->getContactDispatcher().removeListener(this);
+}
+
+//---------------------------------------------------------------------------
+bool Simulation::step(const PlayerCommand& cmd, const float dt)
+{
+    mPlayer->applyCommand(cmd, dt);
+
+    if (cmd.spawnCat)
+    {
+        mCatPool->acquire();
+    }
+
+    std::chrono::high_resolution_clock::time_point stepStart =
+        std::chrono::high_resolution_clock::now();
+
+    // Exactly one step of dt, the caller does the fixed stepping
+    mPhysicsEngine->getDynamicsWorld()->stepSimulation(dt, 0);
+
+    mLastStepTime = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - stepStart).count();
+
+    std::chrono::high_resolution_clock::time_point scanStart =
+        std::chrono::high_resolution_clock::now();
+
+    // Only cat and player contacts come back, see onContact
+    mPhysicsEngine->getContactDispatcher().dispatch();
+
+    mLastHitScanTime = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - scanStart).count();
+
+    if (mContactSounds)
+    {
+        mContactSounds->update(dt);
+    }
+
+    mCatDespawner->update(dt);
+
+    mPlayer->updateAction(mPhysicsEngine->getDynamicsWorld(), dt);
+
+    return mPlayerContacts == 0;
+}
+
+//---------------------------------------------------------------------------
+double Simulation::getLastStepTime() const
+{
+    return mLastStepTime;
+}
+
+//---------------------------------------------------------------------------
+double Simulation::getLastHitScanTime() const
+{
+    return mLastHitScanTime;
+}
+
+//---------------------------------------------------------------------------
+ContactSounds* Simulation::getContactSounds()
+{
+    return mContactSounds;
+}
+
+//---------------------------------------------------------------------------
+void Simulation::onContact(const ContactEvent& event)
+{
+    mPlayerContacts += event.began ? 1 : -1;
+    mPlayerContacts = std::max(mPlayerContacts, 0);
+}
@@ -0,0 +1,50 @@
+#ifndef Simulation_hpp
+#define Simulation_hpp
+
+#include "BulletPhysics.hpp"
+#include "CatDespawner.hpp"
+#include "ContactDispatcher.hpp"
+#include "ContactSounds.hpp"
+#include "CatPool.hpp"
+#include "Player.hpp"
+#include "PlayerCommand.hpp"
+
+// The gameplay that runs once per fixed physics step. Touches Bullet and
+// gameplay state only, never Ogre, so it can run on the physics thread.
+class Simulation : public ContactListener
+{
+public:
+    // sounds may be null when nothing plays them
+    Simulation(BulletPhysics* physics, Player* player, CatPool* pool,
+        CatDespawner* despawner, ContactSounds* sounds);
+    ~Simulation();
+
+    // Runs one physics step. Returns false once the player was hit.
+    bool step(const PlayerCommand& cmd, const float dt);
+
+    // Milliseconds spent in the last stepSimulation call
+    double getLastStepTime() const;
+    // Milliseconds spent dispatching contact events in the last step
+    double getLastHitScanTime() const;
+
+    ContactSounds* getContactSounds();
+
+    // Cat and player contacts starting and ending
+    void onContact(const ContactEvent& event);
+
+private:
+
+    BulletPhysics* mPhysicsEngine;
+    Player* mPlayer;
+    CatPool* mCatPool;
+    CatDespawner* mCatDespawner;
+    ContactSounds* mContactSounds;
+
+    double mLastStepTime;
+    double mLastHitScanTime;
+
+    // Cats touching the player right now
+    int mPlayerContacts;
+};
+
+#endif
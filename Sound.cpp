@@ -1,62 +1,248 @@
 #include "Sound.hpp"
 
+#include <fstream>
+#include <sstream>
+
+// Names used for each SoundId in SOUND_CONFIG_FILE
+static const char* sSoundNames[SOUND_COUNT] = { "Meow", "Score", "Spray", "Move" };
+
+//---------------------------------------------------------------------------
+SoundEffect::SoundEffect()
+	: loaded(0),
+	channel(SOUND_ANY_CHANNEL)
+{
+}
+
+//---------------------------------------------------------------------------
 Sound::Sound()
 	: mBackgroundMusic(0),
-	mEffect(0),
+	mMusicReady(false),
+	mMusicRequested(false),
+	mMusicStarted(false),
+	mStopLoading(false),
 	mMusicVolume(0.3f),
-	mEffectVolume(0.1f),
-	mScoreUp(0),
-	mSpray(0),
-	mMovement(0)
+	mEffectVolume(0.1f)
 {
 }
 
+//---------------------------------------------------------------------------
+Sound::~Sound()
+{
+    if (!mLoader.valid())
+    {
+        return;
+    }
+
+    mStopLoading = true;
+    mLoader.wait();
+
+    Mix_HaltChannel(-1);
+    Mix_HaltMusic();
+
+    for (int id = 0; id < SOUND_COUNT; ++id)
+    {
+        for (size_t i = 0; i < mEffects[id].loaded; ++i)
+        {
+            Mix_FreeChunk(mEffects[id].chunks[i]);
+        }
+    }
+
+    if (mBackgroundMusic)
+    {
+        Mix_FreeMusic(mBackgroundMusic);
+    }
+
+    Mix_CloseAudio();
+}
+
 //---------------------------------------------------------------------------
 void Sound::initSound()
 {
-    srand (time(NULL));
+    // rand is seeded by the game, replays reuse the recorded seed
     Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, 2, 4096);
 
-    mBackgroundMusic = Mix_LoadMUS("The-Power-I-Feel.mp3");
-
-    mMeowEffects.push_back(Mix_LoadWAV("angryMeow.wav"));
-    mMeowEffects.push_back(Mix_LoadWAV("cat.wav"));
-    mMeowEffects.push_back(Mix_LoadWAV("happyPurr.wav"));
+    // Fixed channels for the UI sounds, a capped group of voices for meows
+    Mix_AllocateChannels(SOUND_RESERVED_CHANNELS + SOUND_MAX_VOICES);
+    Mix_ReserveChannels(SOUND_RESERVED_CHANNELS);
+    Mix_GroupChannels(SOUND_RESERVED_CHANNELS, SOUND_RESERVED_CHANNELS + SOUND_MAX_VOICES - 1,
+        SOUND_VOICE_GROUP);
 
-    mScoreUp = Mix_LoadWAV("scoreUp1.wav");
-    mSpray = Mix_LoadWAV("spraySound1.wav");
-    mMovement = Mix_LoadWAV("turningMove.wav");
+    if (!loadRegistry(SOUND_CONFIG_FILE))
+    {
+        std::cerr << "Could not read " << SOUND_CONFIG_FILE << ", playing without sound\n";
+    }
 
     setMusicVolume(mMusicVolume);
     setEffectVolume(mEffectVolume);
 
-    Mix_PlayMusic(mBackgroundMusic, -1);
+    mLoader = std::async(std::launch::async, &Sound::loadAssets, this);
 }
 
 //---------------------------------------------------------------------------
-void Sound::playSound(const char* effectName)
+// Reads the file names only, decoding is left to loadAssets.
+// Each line is Effect=channel file [file ...], or Music=file
+bool Sound::loadRegistry(const std::string& fileName)
 {
-	if (effectName == "meow")
-	{
-		Mix_PlayChannel(-1, mMeowEffects.at(rand() % mMeowEffects.size()) ,0);
-	}
+    std::ifstream file(fileName.c_str());
+    if (!file)
+    {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+
+        size_t split = line.find('=');
+        if (split == std::string::npos)
+        {
+            continue;
+        }
+
+        std::string key;
+        std::istringstream(line.substr(0, split)) >> key;
+        std::istringstream value(line.substr(split + 1));
+
+        if (key == "Music")
+        {
+            value >> mMusicFile;
+            continue;
+        }
 
-	if (effectName == "score")
+        int id = 0;
+        while (id < SOUND_COUNT && key != sSoundNames[id])
+        {
+            ++id;
+        }
+
+        if (id == SOUND_COUNT)
+        {
+            std::cerr << fileName << ": unknown sound " << key << "\n";
+            continue;
+        }
+
+        SoundEffect& effect = mEffects[id];
+        value >> effect.channel;
+
+        std::string wav;
+        while (value >> wav)
+        {
+            effect.files.push_back(wav);
+        }
+        effect.chunks.resize(effect.files.size(), 0);
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// Loader thread. Music first since it only opens the stream, then the
+// effects one file at a time.
+void Sound::loadAssets()
+{
+    if (!mMusicFile.empty())
+    {
+        mBackgroundMusic = Mix_LoadMUS(mMusicFile.c_str());
+        if (!mBackgroundMusic)
+        {
+            std::cerr << "Could not open " << mMusicFile << "\n";
+        }
+    }
+    mMusicReady = true;
+
+    for (int id = 0; id < SOUND_COUNT; ++id)
+    {
+        SoundEffect& effect = mEffects[id];
+
+        for (size_t i = 0; i < effect.files.size(); ++i)
+        {
+            if (mStopLoading)
+            {
+                return;
+            }
+
+            Mix_Chunk* chunk = Mix_LoadWAV(effect.files[i].c_str());
+            if (!chunk)
+            {
+                std::cerr << "Could not load " << effect.files[i] << "\n";
+                continue;
+            }
+
+            size_t slot = effect.loaded;
+            effect.chunks[slot] = chunk;
+            effect.loaded = slot + 1;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+bool Sound::isLoaded() const
+{
+    return mLoader.valid()
+        && mLoader.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+//---------------------------------------------------------------------------
+void Sound::playMusic()
+{
+    mMusicRequested = true;
+    update();
+}
+
+//---------------------------------------------------------------------------
+void Sound::update()
+{
+    if (mMusicRequested && !mMusicStarted && mMusicReady)
+    {
+        if (mBackgroundMusic)
+        {
+            Mix_PlayMusic(mBackgroundMusic, -1);
+        }
+        mMusicStarted = true;
+    }
+}
+
+//---------------------------------------------------------------------------
+void Sound::playSound(const SoundId id)
+{
+	const SoundEffect& effect = mEffects[id];
+	if (effect.loaded == 0)
 	{
-		Mix_PlayChannel(0, mScoreUp, 0);
+		return;
 	}
 
-	if (effectName == "spray")
+	int channel = effect.channel;
+	if (channel == SOUND_ANY_CHANNEL)
 	{
-		Mix_PlayChannel(1, mSpray, 0);
+		// Never steal a voice, a sound that finds none is dropped
+		channel = Mix_GroupAvailable(SOUND_VOICE_GROUP);
+		if (channel < 0)
+		{
+			return;
+		}
 	}
 
-	if (effectName == "move")
+	playSoundOn(id, channel);
+}
+
+//---------------------------------------------------------------------------
+bool Sound::playSoundOn(const SoundId id, const int channel)
+{
+	const SoundEffect& effect = mEffects[id];
+	size_t loaded = effect.loaded;
+	if (loaded == 0)
 	{
-		std::cout << "Move sound\n";
-		Mix_PlayChannel(2, mMovement, 0);
+		return false;
 	}
 
+	return Mix_PlayChannel(channel, effect.chunks[rand() % loaded], 0) >= 0;
+}
+
+//---------------------------------------------------------------------------
+bool Sound::canPlay(const SoundId id) const
+{
+	return mEffects[id].loaded > 0;
 }
 
 //---------------------------------------------------------------------------
@@ -1,33 +1,80 @@
 #ifndef Sound_hpp
 #define Sound_hpp
 
+#include "SoundId.hpp"
+
 #include <SDL.h>
 #include <SDL_mixer.h>
 
+#include <atomic>
+#include <future>
 #include <iostream>
+#include <string>
 #include <vector>
 #include <stdlib.h>     /* srand, rand */
 #include <time.h>       /* time */
 
+#define SOUND_CONFIG_FILE "sounds.cfg"
+#define SOUND_RESERVED_CHANNELS 3 // Score, spray and move each own a channel
+#define SOUND_MAX_VOICES 6 // Shared-channel sounds that can play at once
+#define SOUND_VOICE_GROUP 1
+#define SOUND_ANY_CHANNEL -1
+
+// The chunks for one SoundId and where they play. chunks is sized before
+// loading starts; the loader fills it in order and bumps loaded after each
+// one, so the first loaded entries are always safe to play.
+struct SoundEffect
+{
+    SoundEffect();
+
+    std::vector<std::string> files;
+    std::vector<Mix_Chunk*> chunks;
+    std::atomic<size_t> loaded;
+    int channel; // SOUND_ANY_CHANNEL for the shared voices
+};
+
+// Audio assets are decoded on a background thread so opening the mixer
+// never stalls a frame. Effects play as soon as their first file is in;
+// until then they are silent. Music is streamed from disk by the mixer.
 class Sound 
 {
 private:
+	bool loadRegistry(const std::string& fileName);
+	void loadAssets();
+
 	Mix_Music* mBackgroundMusic;
-    Mix_Chunk* mEffect;
-    std::vector<Mix_Chunk*> mMeowEffects;
-    
-    Mix_Chunk* mScoreUp;
-    Mix_Chunk* mSpray;
-    Mix_Chunk* mMovement;
+    std::string mMusicFile;
+    std::atomic<bool> mMusicReady;
+    bool mMusicRequested;
+    bool mMusicStarted;
+
+    SoundEffect mEffects[SOUND_COUNT];
+
+    std::future<void> mLoader;
+    std::atomic<bool> mStopLoading;
 
     float mMusicVolume;
     float mEffectVolume; 
 public:
 	Sound();
+	~Sound();
 
+	// Opens the mixer and starts loading in the background
 	void initSound();
+	// True once every file has been loaded or has failed
+	bool isLoaded() const;
+
+	// Starts the music now, or as soon as it has been opened
+	void playMusic();
+	// Render thread, once a frame
+	void update();
 
-	void playSound(const char* effectName);
+	void playSound(const SoundId id);
+	// Plays on the given channel, cutting off what was there. False when
+	// the effect has nothing loaded yet.
+	bool playSoundOn(const SoundId id, const int channel);
+	// True once at least one file of the effect has loaded
+	bool canPlay(const SoundId id) const;
 
 	void setMusicVolume(const float volume);
 	void setEffectVolume(const float volume);
@@ -0,0 +1,15 @@
+#ifndef SoundId_hpp
+#define SoundId_hpp
+
+// Every effect the game can play. The names in SOUND_CONFIG_FILE map onto
+// these once at load time; playing a sound is an array index after that.
+enum SoundId
+{
+    SOUND_MEOW,
+    SOUND_SCORE,
+    SOUND_SPRAY,
+    SOUND_MOVE,
+    SOUND_COUNT
+};
+
+#endif
@@ -0,0 +1,212 @@
+#include "SpatialAudio.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// A sound waiting for a voice, with how well it would be heard
+struct Candidate
+{
+    const SoundEvent* sound;
+    float audibility;
+};
+
+static bool isMoreAudible(const Candidate& a, const Candidate& b)
+{
+    return a.audibility > b.audibility;
+}
+
+//---------------------------------------------------------------------------
+Voice::Voice()
+    : channel(-1),
+    loudness(0.0f),
+    audibility(0.0f)
+{
+}
+
+//---------------------------------------------------------------------------
+SpatialAudio::SpatialAudio(Sound* sound)
+    : mSound(sound),
+    mListenerPosition(Ogre::Vector3::ZERO),
+    mListenerRight(Ogre::Vector3::UNIT_X),
+    mStarted(0),
+    mStolen(0),
+    mCulled(0),
+    mDropped(0)
+{
+    // The voices are the shared group Sound sets up
+    for (int i = 0; i < SOUND_MAX_VOICES; ++i)
+    {
+        mVoices[i].channel = SOUND_RESERVED_CHANNELS + i;
+    }
+}
+
+//---------------------------------------------------------------------------
+void SpatialAudio::setListener(const Ogre::Vector3& position, const Ogre::Vector3& right)
+{
+    mListenerPosition = position;
+    mListenerRight = right;
+}
+
+//---------------------------------------------------------------------------
+void SpatialAudio::play(const std::vector<SoundEvent>& sounds)
+{
+    std::vector<Candidate> candidates;
+    candidates.reserve(sounds.size());
+
+    for (size_t i = 0; i < sounds.size(); ++i)
+    {
+        const btVector3& origin = sounds[i].position;
+        Ogre::Vector3 position(origin.getX(), origin.getY(), origin.getZ());
+        float loudness = std::min(1.0f, float(sounds[i].impulse) / SPATIAL_FULL_IMPULSE);
+
+        Candidate candidate = { &sounds[i], getAudibility(position, loudness) };
+        if (candidate.audibility < SPATIAL_MIN_AUDIBILITY)
+        {
+            ++mCulled;
+            continue;
+        }
+
+        candidates.push_back(candidate);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), isMoreAudible);
+
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        const SoundEvent& sound = *candidates[i].sound;
+
+        // Never cut a voice off for an effect with nothing to play
+        if (!mSound->canPlay(sound.effect))
+        {
+            ++mDropped;
+            continue;
+        }
+
+        Voice* voice = findVoice();
+        bool stealing = Mix_Playing(voice->channel) != 0;
+
+        if (stealing && voice->audibility >= candidates[i].audibility)
+        {
+            // Everything left is quieter still
+            mCulled += candidates.size() - i;
+            return;
+        }
+
+        // Playing on the channel cuts off what was there
+        if (!mSound->playSoundOn(sound.effect, voice->channel))
+        {
+            // Free to take; update() repans it if the old sound survived
+            voice->audibility = 0.0f;
+            ++mDropped;
+            continue;
+        }
+
+        if (stealing)
+        {
+            ++mStolen;
+        }
+
+        voice->position = Ogre::Vector3(sound.position.getX(), sound.position.getY(),
+            sound.position.getZ());
+        voice->loudness = std::min(1.0f, float(sound.impulse) / SPATIAL_FULL_IMPULSE);
+        pan(*voice);
+        ++mStarted;
+    }
+}
+
+//---------------------------------------------------------------------------
+void SpatialAudio::update()
+{
+    for (int i = 0; i < SOUND_MAX_VOICES; ++i)
+    {
+        if (Mix_Playing(mVoices[i].channel))
+        {
+            pan(mVoices[i]);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+// Inverse distance past the reference distance, faded out to nothing at the
+// maximum so far sounds do not linger at a low volume
+float SpatialAudio::getAudibility(const Ogre::Vector3& position, const float loudness) const
+{
+    float distance = position.distance(mListenerPosition);
+    if (distance >= SPATIAL_MAX_DISTANCE)
+    {
+        return 0.0f;
+    }
+
+    float gain = SPATIAL_REFERENCE_DISTANCE / std::max(distance, SPATIAL_REFERENCE_DISTANCE);
+    gain *= 1.0f - distance / SPATIAL_MAX_DISTANCE;
+
+    return loudness * gain;
+}
+
+//---------------------------------------------------------------------------
+// Equal power pan from the side the emitter is on
+void SpatialAudio::pan(Voice& voice)
+{
+    voice.audibility = getAudibility(voice.position, voice.loudness);
+
+    Ogre::Vector3 direction = voice.position - mListenerPosition;
+    float side = 0.0f;
+    if (direction.squaredLength() > 1.0f)
+    {
+        side = direction.normalisedCopy().dotProduct(mListenerRight);
+    }
+
+    float angle = (side + 1.0f) * 0.25f * float(M_PI);
+    float volume = 255.0f * voice.audibility;
+
+    // Both sides at zero would turn the effect off rather than silence it
+    Uint8 left = Uint8(std::max(1.0f, volume * std::cos(angle)));
+    Uint8 right = Uint8(std::max(1.0f, volume * std::sin(angle)));
+    Mix_SetPanning(voice.channel, left, right);
+}
+
+//---------------------------------------------------------------------------
+// A free voice if there is one, otherwise the quietest
+Voice* SpatialAudio::findVoice()
+{
+    Voice* quietest = &mVoices[0];
+
+    for (int i = 0; i < SOUND_MAX_VOICES; ++i)
+    {
+        if (!Mix_Playing(mVoices[i].channel))
+        {
+            return &mVoices[i];
+        }
+
+        if (mVoices[i].audibility < quietest->audibility)
+        {
+            quietest = &mVoices[i];
+        }
+    }
+
+    return quietest;
+}
+
+//---------------------------------------------------------------------------
+unsigned long SpatialAudio::getStarted() const
+{
+    return mStarted;
+}
+
+//---------------------------------------------------------------------------
+unsigned long SpatialAudio::getStolen() const
+{
+    return mStolen;
+}
+
+//---------------------------------------------------------------------------
+unsigned long SpatialAudio::getCulled() const
+{
+    return mCulled;
+}
+
+//---------------------------------------------------------------------------
+unsigned long SpatialAudio::getDropped() const
+{
+    return mDropped;
+}
@@ -0,0 +1,66 @@
+#ifndef SpatialAudio_hpp
+#define SpatialAudio_hpp
+
+#include "ContactSounds.hpp"
+#include "Sound.hpp"
+
+#include <OgreVector3.h>
+
+#include <vector>
+
+#define SPATIAL_REFERENCE_DISTANCE 300.0f // Full volume this close to the listener
+#define SPATIAL_MAX_DISTANCE 4000.0f // Silent this far away
+#define SPATIAL_FULL_IMPULSE 3000.0f // Contacts this hard play at full volume
+#define SPATIAL_MIN_AUDIBILITY 0.02f // Quieter sounds are not worth a voice
+
+// One of the shared channels and the sound on it
+struct Voice
+{
+    Voice();
+
+    int channel;
+    Ogre::Vector3 position;
+    float loudness; // 0 to 1, before distance
+    float audibility; // Loudness after distance, last time it was panned
+};
+
+// Places sounds around the listener on the shared voice channels. Each sound
+// is panned and attenuated from where its emitter was, and only the
+// SOUND_MAX_VOICES most audible play; a louder sound takes over the quietest
+// voice. Render thread only.
+class SpatialAudio
+{
+public:
+    SpatialAudio(Sound* sound);
+
+    void setListener(const Ogre::Vector3& position, const Ogre::Vector3& right);
+
+    // Starts the most audible of these sounds
+    void play(const std::vector<SoundEvent>& sounds);
+    // Repans the live voices for the current listener
+    void update();
+
+    unsigned long getStarted() const;
+    unsigned long getStolen() const; // Cut off for a louder sound
+    unsigned long getCulled() const; // Too quiet, or quieter than every live voice
+    unsigned long getDropped() const; // Given a voice but the mixer did not play it
+
+private:
+    float getAudibility(const Ogre::Vector3& position, const float loudness) const;
+    void pan(Voice& voice);
+    Voice* findVoice();
+
+    Sound* mSound;
+
+    Ogre::Vector3 mListenerPosition;
+    Ogre::Vector3 mListenerRight;
+
+    Voice mVoices[SOUND_MAX_VOICES];
+
+    unsigned long mStarted;
+    unsigned long mStolen;
+    unsigned long mCulled;
+    unsigned long mDropped;
+};
+
+#endif
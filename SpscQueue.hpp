@@ -0,0 +1,61 @@
+#ifndef SpscQueue_hpp
+#define SpscQueue_hpp
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free ring buffer for exactly one producer thread and one consumer
+// thread. One slot is kept empty to tell a full queue from an empty one.
+template <class T, size_t Capacity>
+class SpscQueue
+{
+public:
+    SpscQueue()
+        : mHead(0),
+        mTail(0)
+    {
+    }
+
+    // Producer side. Returns false when the queue is full.
+    bool push(const T& item)
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        size_t next = (tail + 1) % Capacity;
+
+        if (next == mHead.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        mItems[tail] = item;
+        mTail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when the queue is empty.
+    bool pop(T& item)
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+
+        if (head == mTail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        item = mItems[head];
+        mHead.store((head + 1) % Capacity, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+    }
+
+private:
+    T mItems[Capacity];
+    std::atomic<size_t> mHead;
+    std::atomic<size_t> mTail;
+};
+
+#endif
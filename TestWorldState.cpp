@@ -0,0 +1,315 @@
+#include "Arena.hpp"
+#include "BulletPhysics.hpp"
+#include "CatDespawner.hpp"
+#include "CatPool.hpp"
+#include "FixedTimestep.hpp"
+#include "Level.hpp"
+#include "PhysicsThread.hpp"
+#include "Player.hpp"
+#include "Simulation.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define TEST_STATE_FILE "test_world_state.state"
+#define TEST_BAD_STATE_FILE "test_world_state_bad.state"
+#define TEST_STEPS 240
+#define TEST_STEPS_AFTER_SAVE 240
+#define TEST_SPAWN_INTERVAL 30
+#define TEST_TIME_TO_LIVE 3.0f // Short enough for cats to retire after the save
+#define TEST_TOLERANCE 1e-4 // States hold floats, relative to the value
+
+// Where a state file keeps its object count, after the magic and version
+#define TEST_COUNT_OFFSET 8
+
+// What a checkpoint has to bring back for one tracked object
+struct ObjectState
+{
+    btTransform transform;
+    btVector3 linear;
+    btVector3 angular;
+    int activation;
+    bool inWorld;
+    int group;
+    int mask;
+};
+
+//---------------------------------------------------------------------------
+static int fail(const std::string& message)
+{
+    std::cerr << "test_world_state: " << message << std::endl;
+    std::remove(TEST_STATE_FILE);
+    std::remove(TEST_BAD_STATE_FILE);
+    return 1;
+}
+
+//---------------------------------------------------------------------------
+static ObjectState capture(btCollisionObject* object)
+{
+    ObjectState state;
+    state.transform = object->getWorldTransform();
+    state.linear = btVector3(0, 0, 0);
+    state.angular = btVector3(0, 0, 0);
+
+    btRigidBody* body = btRigidBody::upcast(object);
+    if (body)
+    {
+        state.linear = body->getLinearVelocity();
+        state.angular = body->getAngularVelocity();
+    }
+
+    const btBroadphaseProxy* proxy = object->getBroadphaseHandle();
+    state.activation = object->getActivationState();
+    state.inWorld = proxy != 0;
+    state.group = proxy ? proxy->m_collisionFilterGroup : 0;
+    state.mask = proxy ? proxy->m_collisionFilterMask : 0;
+    return state;
+}
+
+//---------------------------------------------------------------------------
+static std::vector<ObjectState> captureWorld(BulletPhysics& physics)
+{
+    std::vector<ObjectState> states;
+    for (size_t i = 0; i < physics.getStateObjectCount(); ++i)
+    {
+        states.push_back(capture(physics.getStateObject(i)));
+    }
+    return states;
+}
+
+//---------------------------------------------------------------------------
+static bool isNear(const btScalar actual, const btScalar expected)
+{
+    return std::fabs(actual - expected) <= TEST_TOLERANCE * (1.0 + std::fabs(expected));
+}
+
+//---------------------------------------------------------------------------
+static bool isNear(const btVector3& actual, const btVector3& expected)
+{
+    return isNear(actual.x(), expected.x()) && isNear(actual.y(), expected.y())
+        && isNear(actual.z(), expected.z());
+}
+
+//---------------------------------------------------------------------------
+// Empty when the object is back as it was, otherwise what differs
+static std::string compare(const ObjectState& actual, const ObjectState& expected)
+{
+    btQuaternion rotation = actual.transform.getRotation();
+    btQuaternion wanted = expected.transform.getRotation();
+    // q and -q are the same rotation
+    bool sameRotation = std::fabs(std::fabs(rotation.dot(wanted)) - 1.0) <= TEST_TOLERANCE;
+
+    if (!isNear(actual.transform.getOrigin(), expected.transform.getOrigin()))
+    {
+        return "origin";
+    }
+    if (!sameRotation)
+    {
+        return "rotation";
+    }
+    if (!isNear(actual.linear, expected.linear))
+    {
+        return "linear velocity";
+    }
+    if (!isNear(actual.angular, expected.angular))
+    {
+        return "angular velocity";
+    }
+    if (actual.activation != expected.activation)
+    {
+        return "activation state";
+    }
+    if (actual.inWorld != expected.inWorld)
+    {
+        return "world membership";
+    }
+    if (actual.group != expected.group || actual.mask != expected.mask)
+    {
+        return "collision filter";
+    }
+    return "";
+}
+
+//---------------------------------------------------------------------------
+static void runSteps(PhysicsThread& thread, const int steps)
+{
+    for (int i = 0; i < steps; ++i)
+    {
+        PlayerCommand cmd;
+        cmd.forward = (i / 60) % 2 == 0;
+        cmd.turnLeft = !cmd.forward;
+        cmd.spawnCat = i % TEST_SPAWN_INTERVAL == 0;
+        thread.pushCommand(cmd);
+        thread.update(PHYSICS_STEP);
+    }
+}
+
+//---------------------------------------------------------------------------
+static bool writeFile(const std::string& fileName, const std::vector<char>& buffer)
+{
+    std::ofstream file(fileName.c_str(), std::ios::binary);
+    file.write(&buffer[0], buffer.size());
+    file.close();
+    return !file.fail();
+}
+
+//---------------------------------------------------------------------------
+// Saves a checkpoint with the physics steps running inline, the way
+// --single-thread runs the game, lets the world move on so cats retire and
+// launch, then loads it and checks every tracked object is back where it
+// was. Files with the wrong magic or object count must be turned away.
+int main()
+{
+    // make check runs from the build tree
+    const char* srcdir = std::getenv("srcdir");
+    std::string levelFile = std::string(srcdir ? srcdir : ".") + "/" + LEVEL_FILE;
+
+    Level level;
+    if (!level.load(levelFile))
+    {
+        return fail("could not load level " + levelFile);
+    }
+
+    PhysicsConfig config;
+    config.multithreaded = false;
+
+    BulletPhysics physics;
+    physics.initObjects(config);
+    physics.getDynamicsWorld()->setGravity(PHYSICS_GRAVITY);
+
+    Player player("Player 1", 0, &physics, 0);
+    CatPool pool(&physics, 0, &player, "Cat.mesh");
+    CatLifetimePolicy policy;
+    policy.timeToLive = TEST_TIME_TO_LIVE;
+    policy.playMin = level.getPlayMin();
+    policy.playMax = level.getPlayMax();
+    CatDespawner despawner(&pool, policy);
+    Simulation simulation(&physics, &player, &pool, &despawner, 0);
+
+    Arena arena(&physics, 0, level);
+    arena.build();
+
+    // The pool only holds the cats spawned so far when the save happens
+    PhysicsThread thread(&simulation, &physics, &pool, &player);
+    runSteps(thread, TEST_STEPS);
+
+    size_t live = pool.getLiveCount();
+    if (live == 0)
+    {
+        return fail("no cats were spawned");
+    }
+
+    if (!thread.saveState(TEST_STATE_FILE))
+    {
+        return fail("could not save " TEST_STATE_FILE);
+    }
+    std::vector<ObjectState> saved = captureWorld(physics);
+
+    std::vector<char> buffer;
+    physics.writeState(buffer);
+
+    // Poses change, old cats expire and new ones launch
+    runSteps(thread, TEST_STEPS_AFTER_SAVE);
+
+    std::vector<ObjectState> moved = captureWorld(physics);
+    size_t changed = 0;
+    size_t membership = 0;
+    for (size_t i = 0; i < saved.size(); ++i)
+    {
+        changed += compare(moved[i], saved[i]).empty() ? 0 : 1;
+        membership += moved[i].inWorld != saved[i].inWorld ? 1 : 0;
+    }
+    if (changed == 0 || membership == 0)
+    {
+        return fail("the world did not move on after the save");
+    }
+
+    if (!thread.loadState(TEST_STATE_FILE))
+    {
+        return fail("could not load " TEST_STATE_FILE);
+    }
+    if (thread.isThreaded())
+    {
+        return fail("loading started the physics thread");
+    }
+    if (physics.getStateObjectCount() != saved.size())
+    {
+        return fail("tracked object count changed across the load");
+    }
+    if (pool.getLiveCount() != live)
+    {
+        return fail("live cat count changed across the load");
+    }
+
+    std::vector<ObjectState> loaded = captureWorld(physics);
+    for (size_t i = 0; i < saved.size(); ++i)
+    {
+        std::string difference = compare(loaded[i], saved[i]);
+        if (!difference.empty())
+        {
+            std::ostringstream message;
+            message << "object " << i << " has the wrong " << difference << " after the load";
+            return fail(message.str());
+        }
+    }
+
+    // A state from another world, or not a state at all, changes nothing
+    std::vector<char> badMagic = buffer;
+    badMagic[0] ^= 0x20;
+    if (physics.readState(badMagic))
+    {
+        return fail("a state with the wrong magic was read");
+    }
+
+    uint32_t count = 0;
+    std::memcpy(&count, &buffer[TEST_COUNT_OFFSET], sizeof(count));
+    size_t recordSize = (buffer.size() - TEST_COUNT_OFFSET - sizeof(count)) / count;
+
+    // One record more, with a size that matches the header
+    std::vector<char> badCount = buffer;
+    ++count;
+    std::memcpy(&badCount[TEST_COUNT_OFFSET], &count, sizeof(count));
+    badCount.resize(buffer.size() + recordSize, 0);
+    if (physics.readState(badCount))
+    {
+        return fail("a state with the wrong object count was read");
+    }
+
+    std::vector<char> truncated(buffer.begin(), buffer.end() - recordSize);
+    if (physics.readState(truncated))
+    {
+        return fail("a truncated state was read");
+    }
+
+    if (!writeFile(TEST_BAD_STATE_FILE, badMagic))
+    {
+        return fail("could not write " TEST_BAD_STATE_FILE);
+    }
+    if (thread.loadState(TEST_BAD_STATE_FILE))
+    {
+        return fail("a state file with the wrong magic was loaded");
+    }
+
+    loaded = captureWorld(physics);
+    for (size_t i = 0; i < saved.size(); ++i)
+    {
+        if (!compare(loaded[i], saved[i]).empty())
+        {
+            return fail("a rejected state changed the world");
+        }
+    }
+
+    std::remove(TEST_STATE_FILE);
+    std::remove(TEST_BAD_STATE_FILE);
+    std::cout << "test_world_state: " << saved.size() << " bodies, " << live
+              << " live cats saved, moved on by " << changed << " and restored" << std::endl;
+    return 0;
+}
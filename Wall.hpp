@@ -7,6 +7,7 @@
 #include <OgreSceneManager.h>
 #include <OgreVector3.h>
 #include <OgreMeshManager.h>
+#include <OgreStaticGeometry.h>
 
 #include <string>
 
@@ -15,30 +16,45 @@ class Wall
 public:
     Wall(BulletPhysics*, Ogre::SceneManager*);
 
-    void createWall(std::string, const float, const float, const float, const float, const float, 
-    	Ogre::Vector3, Ogre::Vector3);
+    // With a batch the wall is added to it instead of getting a scene node;
+    // the returned entity is then only a template until the batch is built
+    Ogre::Entity* createWall(std::string, const float, const float, const float, const float, const float, 
+    	Ogre::Vector3, Ogre::Vector3, Ogre::StaticGeometry* batch = 0);
 
     void createWallPhysics(const float, const float, const float, const float, 
     	const float, const float);
 
-    void createGroundPhysics(const float, const float, const float);
+    // A static plane through the point, facing up unless told otherwise
+    void createGroundPhysics(const float, const float, const float,
+    	const btVector3& normal = btVector3(0.0, 1.0, 0.0));
+
+    // Material of the walls created from now on
+    void setMaterialName(const std::string& material);
 
 private:
 	BulletPhysics* mPhysicsEngine;
 	Ogre::SceneManager* mSceneMgr;
+	std::string mMaterial;
 };
 
 //---------------------------------------------------------------------------
-Wall::Wall(BulletPhysics* physics, Ogre::SceneManager* scnMgr)
+inline Wall::Wall(BulletPhysics* physics, Ogre::SceneManager* scnMgr)
 	: mPhysicsEngine(physics),
-	mSceneMgr(scnMgr)
+	mSceneMgr(scnMgr),
+	mMaterial("Examples/Rockwall")
 {	
 }
 
 //---------------------------------------------------------------------------
-void Wall::createWall(std::string str, const float x, const float y, const float z, 
+inline void Wall::setMaterialName(const std::string& material)
+{
+    mMaterial = material;
+}
+
+//---------------------------------------------------------------------------
+inline Ogre::Entity* Wall::createWall(std::string str, const float x, const float y, const float z, 
 	const float height, const float width, Ogre::Vector3 textureDir,
-	Ogre::Vector3 normal)
+	Ogre::Vector3 normal, Ogre::StaticGeometry* batch)
 {
 	Ogre::Plane plane(textureDir, 0); ////////////////////////////////////////////
     Ogre::MeshManager::getSingleton()
@@ -53,15 +69,23 @@ void Wall::createWall(std::string str, const float x, const float y, const float
 
     Ogre::Entity* wallEntity = mSceneMgr->createEntity(str);
     wallEntity->setCastShadows(false);
-    wallEntity->setMaterialName("Examples/Rockwall");
+    wallEntity->setMaterialName(mMaterial);
+
+    if (batch)
+    {
+        batch->addEntity(wallEntity, Ogre::Vector3(x, y, z));
+        return wallEntity;
+    }
 
     Ogre::SceneNode* wallNode = mSceneMgr->getRootSceneNode()->createChildSceneNode();
     wallNode->attachObject(wallEntity);
     wallNode->setPosition(Ogre::Vector3(x, y, z)); ////////////////////////////////////////////
+
+    return wallEntity;
 }
 
 //---------------------------------------------------------------------------
-void Wall::createWallPhysics(const float x, const float y, const float z, 
+inline void Wall::createWallPhysics(const float x, const float y, const float z, 
 	const float length, const float height, const float depth)
 {
 	// create the plane entity to the physics engine, and attach it to the node
@@ -82,11 +106,12 @@ void Wall::createWallPhysics(const float x, const float y, const float z,
     body->setRestitution(0.9);
 
     //add the body to the dynamics world
-    this->mPhysicsEngine->getDynamicsWorld()->addRigidBody(body);
+    this->mPhysicsEngine->getDynamicsWorld()->addRigidBody(body, COL_WALL, COL_WALL_MASK);
 }
 
 //---------------------------------------------------------------------------
-void Wall::createGroundPhysics(const float x, const float y, const float z)
+inline void Wall::createGroundPhysics(const float x, const float y, const float z,
+	const btVector3& normal)
 {
 	// create the plane entity to the physics engine, and attach it to the node
     btTransform transform;
@@ -96,7 +121,7 @@ void Wall::createGroundPhysics(const float x, const float y, const float z)
     btScalar mass(0.0); // the mass is 0, because the LeftWall is immovable (static)
     btVector3 localInertia(0, 0, 0);
 
-    btCollisionShape* shape = new btStaticPlaneShape(btVector3(0.0, 1.0, 0.0), 0.0);
+    btCollisionShape* shape = new btStaticPlaneShape(normal, 0.0);
     btDefaultMotionState* motionState = new btDefaultMotionState(transform); ////////////////////////////////////////////
 
     shape->calculateLocalInertia(mass, localInertia);
@@ -106,7 +131,7 @@ void Wall::createGroundPhysics(const float x, const float y, const float z)
     body->setRestitution(0.9);
 
     //add the body to the dynamics world
-    this->mPhysicsEngine->getDynamicsWorld()->addRigidBody(body);
+    this->mPhysicsEngine->getDynamicsWorld()->addRigidBody(body, COL_WALL, COL_WALL_MASK);
 }
 
 #endif
@@ -0,0 +1,38 @@
+#version 120
+
+// Hardware instanced cat. The 3x4 world matrix of the instance comes in
+// uv1 to uv3, one row each.
+attribute vec4 vertex;
+attribute vec3 normal;
+attribute vec4 uv0;
+attribute vec4 uv1;
+attribute vec4 uv2;
+attribute vec4 uv3;
+
+uniform mat4 viewProjMatrix;
+uniform vec4 lightPosition;
+uniform vec4 lightDiffuse;
+uniform vec4 surfaceDiffuse;
+
+varying vec2 texCoord;
+varying vec4 colour;
+
+void main()
+{
+    mat4 worldMatrix;
+    worldMatrix[0] = uv1;
+    worldMatrix[1] = uv2;
+    worldMatrix[2] = uv3;
+    worldMatrix[3] = vec4(0.0, 0.0, 0.0, 1.0);
+
+    vec4 worldPos = vertex * worldMatrix;
+    vec3 worldNormal = normalize(normal * mat3(worldMatrix));
+
+    // w is 0 for a directional light, so this is the direction to it
+    vec3 toLight = normalize(lightPosition.xyz - worldPos.xyz * lightPosition.w);
+    colour = surfaceDiffuse * lightDiffuse * max(dot(worldNormal, toLight), 0.0);
+    colour.a = surfaceDiffuse.a;
+
+    texCoord = uv0.xy;
+    gl_Position = viewProjMatrix * worldPos;
+}